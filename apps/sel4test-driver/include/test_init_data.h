@@ -9,9 +9,88 @@
 
 #include <sel4/sel4.h>
 #include <sel4test/test.h>
+#include <sel4test-driver/gen_config.h>
 #include <sel4utils/elf.h>
 
 #define TEST_PROCESS_CSPACE_SIZE_BITS 17
+/* number of words in the bitmap of untypeds used by a test */
+#define UNTYPEDS_USED_WORDS ((CONFIG_MAX_TEST_UNTYPEDS + seL4_WordBits - 1) / seL4_WordBits)
+/* Test type of tests that run one after another in the same test process. It
+ * follows the types defined by libsel4test, so PERSISTENT tests run last. */
+#define PERSISTENT ((test_type_name_t) (BASIC + 1))
+/* A test process running PERSISTENT tests sends its result with seL4_Call and
+ * this in the second message register, then runs the test named in the init
+ * data once it gets the reply. */
+#define TEST_WAITING_FOR_NEXT 1
+
+/* A test process starts with a seed untyped, and asks the driver for another
+ * untyped whenever its allocator runs dry. The request is an sel4rpc memory
+ * request for an untyped at UNTYPED_REFILL_ADDRESS, which no untyped is at,
+ * and the size asked for. The driver replies with the cookie of the smallest
+ * untyped of the test that is at least that size and was not handed out yet,
+ * or with an error if there is none. The cookie has the index of the untyped
+ * from untypeds.start and its size. */
+#define UNTYPED_REFILL_ADDRESS ((seL4_Word) -1)
+#define UNTYPED_COOKIE(index, size_bits) (((seL4_Word) (index) << 8) | (size_bits))
+#define UNTYPED_COOKIE_INDEX(cookie) ((cookie) >> 8)
+#define UNTYPED_COOKIE_SIZE_BITS(cookie) ((cookie) & 0xff)
+/* cookie of the seed when the test has no untypeds */
+#define UNTYPED_COOKIE_NONE ((seL4_Word) -1)
+
+/* Output of a test running in parallel with others. The test prints into
+ * this rather than to the console, and the driver prints it once the test
+ * has finished, so that the output of different tests does not mix. */
+#define TEST_OUTPUT_PAGES 4
+typedef struct {
+    /* number of characters in data */
+    seL4_Word len;
+    /* set if the test printed more than fits */
+    seL4_Word truncated;
+    char data[TEST_OUTPUT_PAGES * PAGE_SIZE_4K - 2 * sizeof(seL4_Word)];
+} test_output_t;
+
+/* Deadline of a test that does not use CONFIG_TEST_DEADLINE_MS, in ms or 0
+ * for none. The driver reads these from the _test_deadline section of the
+ * tests image, see DEFINE_TEST_DEADLINE. */
+typedef struct {
+    char name[TEST_NAME_MAX];
+    uint64_t ms;
+} test_deadline_t;
+
+/* A test that is known to fail now and then. It is run again up to retries
+ * times when it fails. If every attempt fails and quarantining is turned on,
+ * it is reported as quarantined rather than failing the run. See
+ * DEFINE_TEST_FLAKY. */
+typedef struct {
+    char name[TEST_NAME_MAX];
+    uint64_t retries;
+} test_flaky_t;
+
+/* Resources used by the test process, filled in by the test process when
+ * CONFIG_REPORT_RESOURCES is set. They are reset before each test, apart from
+ * the heap and stack, which are the high-water marks of the process. */
+typedef struct {
+    /* bytes retyped from the untypeds, for each object type, out of the
+     * bytes of all the untypeds of the test (filled in by the driver) */
+    seL4_Word retyped_bytes[seL4_ObjectTypeCount];
+    seL4_Word untyped_bytes;
+    /* untyped refills the test asked for, counted by the driver */
+    seL4_Word untyped_refills;
+    /* pages of the image paged in on a fault, counted by the driver
+     * (CONFIG_DEMAND_PAGING) */
+    seL4_Word paged_in;
+    /* slots in use, and the most in use at once, out of the max_slots in
+     * free_slots */
+    seL4_Word slots;
+    seL4_Word peak_slots;
+    seL4_Word max_slots;
+    /* highest heap use, out of heap_size */
+    seL4_Word heap_bytes;
+    seL4_Word heap_size;
+    /* deepest stack use, out of the stack_pages */
+    seL4_Word stack_bytes;
+} test_usage_t;
+
 /* Init data shared between sel4test-driver and the sel4test-tests app -- the
  * sel4test-driver creates a shmem page to be shared between the driver and the
  * test child processes, and uses this struct to pass the data in the shmem
@@ -53,11 +132,19 @@ typedef struct {
 
     /* range of untyped memory in the cspace */
     seL4_SlotRegion untypeds;
-    /* size of untyped that each untyped cap corresponds to
-     * (size of the cap at untypeds.start is untyped_size_bits_lits[0]) */
-    uint8_t untyped_size_bits_list[CONFIG_MAX_NUM_BOOTINFO_UNTYPED_CAPS];
+    /* bytes of memory in the boot info untypeds that are not device memory */
+    seL4_Word total_ram_bytes;
+    /* cookie of the untyped the test starts with, see UNTYPED_COOKIE */
+    seL4_Word untyped_seed;
+    /* bitmap of the untypeds that the driver has handed to the test process,
+     * as its seed or a refill, and so may have been retyped (bit i is the
+     * cap at untypeds.start + i). The driver only revokes these after the
+     * test. */
+    seL4_Word untypeds_used[UNTYPEDS_USED_WORDS];
     /* name of the test to run */
     char name[TEST_NAME_MAX];
+    /* index of the test in the _test_case section of the tests image */
+    seL4_Word test_index;
     /* priority the test process is running at */
     int priority;
 
@@ -95,6 +182,14 @@ typedef struct {
     /* number of available cores */
     seL4_Word cores;
 
+    /* where the test process buffers its output, set by the test process */
+    test_output_t *output;
+
+    /* resources used by the test */
+    test_usage_t usage;
+
 } test_init_data_t;
 
-compile_time_assert(init_data_fits_in_ipc_buffer, sizeof(test_init_data_t) < PAGE_SIZE_4K);
+/* The init data takes as many pages as it needs, which are mapped one after
+ * the other in both the driver and the test process. */
+#define TEST_INIT_DATA_PAGES ((sizeof(test_init_data_t) + PAGE_SIZE_4K - 1) / PAGE_SIZE_4K)
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <sel4test/test.h>
+
+/* Generated by tools/gen_test_registry.py: TEST_UNSELECTED_<name> is defined
+ * to 1 for every test that does not match the test regex. */
+#include <test_registry_unselected.h>
+
+/* TEST_IS_SET(m) is 1 if m is defined to 1, and 0 if it is not defined. */
+#define TEST_PLACEHOLDER_1 0,
+#define TEST_SECOND(_ignored, _value, ...) _value
+#define TEST_IS_SET_(_arg_or_junk) TEST_SECOND(_arg_or_junk 1, 0, 0)
+#define TEST_IS_SET__(_value) TEST_IS_SET_(TEST_PLACEHOLDER_##_value)
+#define TEST_IS_SET(_macro) TEST_IS_SET__(_macro)
+
+#define TEST_CASE_ATTRS_0 __attribute__((used)) __attribute__((section("_test_case")))
+#define TEST_CASE_ATTRS_1 static __attribute__((unused))
+#define TEST_CASE_ATTRS__(_unselected) TEST_CASE_ATTRS_##_unselected
+#define TEST_CASE_ATTRS_(_unselected) TEST_CASE_ATTRS__(_unselected)
+
+/* A test that will not run is left out of the _test_case section, so that the
+ * compiler drops it along with its function. A test the generator did not
+ * find is kept, and filtered by the driver at boot as before. */
+#undef DEFINE_TEST_WITH_TYPE
+#define DEFINE_TEST_WITH_TYPE(_name, _description, _function, _test_type, _enabled) \
+    TEST_CASE_ATTRS_(TEST_IS_SET(TEST_UNSELECTED_##_name)) struct testcase TEST_##_name = { \
+        #_name, \
+        _description, \
+        (test_fn)_function, \
+        _test_type, \
+        _enabled, \
+    };
@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026, UNSW
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+
+"""
+Run sel4test, and relaunch it after the test that crashed it when it crashes.
+
+The command is run through the shell, with {config} replaced by the path of a
+run config blob that sets the start index of the run (see runconfig.h). The
+image has to read its run config from memory (Sel4testRunConfigPaddr), for
+example with QEMU's loader device:
+
+  relaunch.py --output report.log -- \\
+      './simulate --extra-qemu-args="-device loader,file={config},addr=0x50000000,force-raw=on"'
+
+A run has crashed when the command exits, or prints nothing for --timeout
+seconds, or prints a line matching --crash-regex, before the end of the
+summary. The test that was running is counted as failed, and the command is
+run again from the test after it. The serial output of every run is kept in
+--log-dir, and merged into one report in --output: the logs one after the
+other in text mode, or one testsuite in XML mode.
+
+Only runs that go through the tests once, in order, can be resumed by test
+index. A crash after the driver starts running tests in parallel, or in soak
+mode, is reported without relaunching.
+"""
+
+import argparse
+import os
+import re
+import selectors
+import subprocess
+import sys
+import time
+
+RUN_CONFIG_MAGIC = 'sel4test-run-config'
+RANGE_RE = re.compile(r'^Running tests (\d+) to (\d+) of (\d+)$')
+STARTING_RE = re.compile(r'^Starting test (\d+): (.*)$')
+TESTCASE_END = '\t</testcase>'
+# lines after which test indices no longer say where to resume the run
+PARALLEL_RE = re.compile(r'^Running \d+ \w+ tests in parallel on \d+ cores$')
+SOAK_RE = re.compile(r'^Soak iteration \d+$')
+# the last line of the summary of a run
+FINISHED_RE = re.compile(r'^(All is well in the universe|\*\*\* FAILURES DETECTED \*\*\*|'
+                         r'\*\*\* ALL tests not run \*\*\*)$')
+
+# tests of the driver itself, that every run has
+DRIVER_TESTS = {'Test that there are tests', 'Test all tests ran'}
+
+
+class Run:
+    def __init__(self, start):
+        self.start = start
+        self.lines = []
+        self.total = None
+        # tests started, or finished in XML mode, counting the first driver test
+        self.started = 0
+        self.names = {}
+        self.finished = False
+        self.crash = None
+        # why the run cannot be resumed by test index, None if it can
+        self.unresumable = None
+
+    def feed(self, line):
+        self.lines.append(line)
+        match = RANGE_RE.match(line)
+        if match:
+            self.total = int(match.group(3))
+        match = STARTING_RE.match(line)
+        if match:
+            self.started = int(match.group(1))
+            self.names[self.started] = match.group(2)
+        if line == TESTCASE_END:
+            self.started += 1
+        if PARALLEL_RE.match(line):
+            self.unresumable = 'tests run in parallel'
+        if SOAK_RE.match(line):
+            self.unresumable = 'soak mode'
+        if FINISHED_RE.match(line):
+            self.finished = True
+
+    def crashed_index(self):
+        """Index of the test that was running when the run crashed"""
+        return self.start + max(self.started, 1) - 1
+
+
+def write_config(path, base, start, end):
+    with open(path, 'w') as f:
+        f.write(RUN_CONFIG_MAGIC + '\n')
+        for line in base:
+            f.write(line + '\n')
+        f.write('start=%d\n' % start)
+        if end is not None:
+            f.write('end=%d\n' % end)
+
+
+def read_base_config(path):
+    if path is None:
+        return []
+    with open(path) as f:
+        lines = f.read().splitlines()
+    if not lines or lines[0].strip() != RUN_CONFIG_MAGIC:
+        sys.exit('%s does not start with %s' % (path, RUN_CONFIG_MAGIC))
+    return [l for l in lines[1:] if l.split('=', 1)[0].strip() not in ('start', 'end')]
+
+
+def launch(command, run, timeout, crash_re, log):
+    process = subprocess.Popen(command, shell=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    selector = selectors.DefaultSelector()
+    selector.register(process.stdout, selectors.EVENT_READ)
+    pending = b''
+    last_output = time.monotonic()
+    try:
+        while not run.finished and run.crash is None:
+            if not selector.select(timeout=1):
+                if time.monotonic() - last_output > timeout:
+                    run.crash = 'no output for %d s' % timeout
+                continue
+            data = os.read(process.stdout.fileno(), 4096)
+            if not data:
+                run.crash = 'exited with %s' % process.wait()
+                break
+            last_output = time.monotonic()
+            sys.stdout.buffer.write(data)
+            sys.stdout.flush()
+            log.write(data)
+            pending += data
+            *lines, pending = pending.split(b'\n')
+            for line in lines:
+                line = line.decode(errors='replace').rstrip('\r')
+                run.feed(line)
+                if crash_re is not None and crash_re.search(line):
+                    run.crash = line
+                if run.finished or run.crash is not None:
+                    break
+    finally:
+        if process.poll() is None:
+            process.kill()
+            process.wait()
+
+
+def merge_text(runs):
+    out = []
+    for run in runs:
+        if run is not runs[0]:
+            out.append('=== Relaunched from test %d ===' % run.start)
+        out.extend(run.lines)
+        if run.crash is not None and run.unresumable is not None:
+            # the index, and in parallel the name, of the test is not known
+            out.append('CRASHED: %s: %s' % (run.unresumable, run.crash))
+        elif run.crash is not None:
+            index = run.crashed_index()
+            name = run.names.get(max(run.started, 1), 'unknown')
+            out.append('CRASHED: test %d %s: %s' % (index, name, run.crash))
+    return out
+
+
+def merge_xml(runs):
+    out = ['<testsuite>']
+    for run in runs:
+        case = None
+        for line in run.lines:
+            if line.startswith('\t<testcase '):
+                case = [line]
+            elif case is not None:
+                case.append(line)
+                if line == TESTCASE_END:
+                    name = re.search(r'name="([^"]*)"', case[0]).group(1)
+                    if name not in DRIVER_TESTS:
+                        out.extend(case)
+                    case = None
+        if run.crash is not None:
+            name = run.unresumable if run.unresumable is not None else 'test %d' % run.crashed_index()
+            out.append('\t<testcase classname="sel4test" name="%s">' % name)
+            out.append('\t\t<error message="crashed the run: %s"/>' %
+                       run.crash.replace('&', '&amp;').replace('"', '&quot;').replace('<', '&lt;'))
+            out.append(TESTCASE_END)
+    out.append('</testsuite>')
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--output', required=True, help='merged report to write')
+    parser.add_argument('--log-dir', default='.', help='directory to keep the log of each run in')
+    parser.add_argument('--config', help='run config to add the start and end index to')
+    parser.add_argument('--start', type=int, default=0, help='index of the first test to run')
+    parser.add_argument('--end', type=int, help='index one past the last test to run')
+    parser.add_argument('--timeout', type=int, default=300,
+                        help='seconds without output after which a run has crashed')
+    parser.add_argument('--crash-regex', help='output that means a run has crashed')
+    parser.add_argument('--max-relaunches', type=int, default=20, help='times to relaunch at most')
+    parser.add_argument('command', help='command that runs the image, with {config} for the run config')
+    args = parser.parse_args()
+
+    base = read_base_config(args.config)
+    crash_re = re.compile(args.crash_regex) if args.crash_regex else None
+    config = os.path.abspath(os.path.join(args.log_dir, 'relaunch-run.conf'))
+    os.makedirs(args.log_dir, exist_ok=True)
+
+    runs = []
+    start = args.start
+    while True:
+        run = Run(start)
+        runs.append(run)
+        write_config(config, base, start, args.end)
+        log_path = os.path.join(args.log_dir, 'relaunch-%d.log' % (len(runs) - 1))
+        with open(log_path, 'wb') as log:
+            launch(args.command.replace('{config}', config), run, args.timeout, crash_re, log)
+        if run.crash is None:
+            break
+        if run.total is None:
+            sys.stderr.write('Run crashed before it selected its tests: %s\n' % run.crash)
+            break
+        if run.unresumable is not None:
+            sys.stderr.write('Run crashed (%s), but cannot be resumed by test index in %s\n' %
+                             (run.crash, run.unresumable))
+            break
+        start = run.crashed_index() + 1
+        sys.stderr.write('Test %d crashed the run (%s), relaunching from test %d\n' %
+                         (start - 1, run.crash, start))
+        end = run.total if args.end is None else min(args.end, run.total)
+        if start >= end:
+            break
+        if len(runs) > args.max_relaunches:
+            sys.stderr.write('Giving up after %d relaunches\n' % args.max_relaunches)
+            break
+
+    xml = any(line.startswith('<testsuite') for run in runs for line in run.lines)
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(merge_xml(runs) if xml else merge_text(runs)) + '\n')
+
+    crashes = [run for run in runs if run.crash is not None]
+    passed = not crashes and 'All is well in the universe' in runs[-1].lines
+    print('%d runs, %d crashed%s' % (len(runs), len(crashes),
+                                      ''.join('\n  %s: %s' % (run.unresumable or 'test %d' % run.crashed_index(),
+                                                                run.crash)
+                                              for run in crashes)))
+    sys.exit(0 if passed else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <utils/util.h>
+
+#include "boot.h"
+#include "timer.h"
+
+typedef struct {
+    const char *name;
+    bool timed;
+    uint64_t ns;
+} boot_phase_t;
+
+static boot_phase_t phases[MAX_BOOT_PHASES];
+static int num_phases;
+
+static bool timing;
+/* end of the last phase timed */
+static uint64_t mark;
+static uint64_t total;
+
+void boot_start_timing(driver_env_t env)
+{
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        timing = true;
+        mark = timestamp(env);
+    }
+}
+
+void boot_phase_end(driver_env_t env, const char *name)
+{
+    if (num_phases == MAX_BOOT_PHASES) {
+        ZF_LOGW("Too many boot phases to profile %s", name);
+        return;
+    }
+    boot_phase_t *phase = &phases[num_phases++];
+    phase->name = name;
+    if (timing) {
+        uint64_t now = timestamp(env);
+        phase->timed = true;
+        phase->ns = now - mark;
+        total += phase->ns;
+        mark = now;
+    }
+}
+
+void boot_print_profile(void)
+{
+    printf("Boot profile:");
+    for (int i = 0; i < num_phases; i++) {
+        if (phases[i].timed) {
+            printf(" %s %llu.%03llu ms%s", phases[i].name, (unsigned long long)(phases[i].ns / NS_IN_MS),
+                   (unsigned long long)(phases[i].ns % NS_IN_MS / NS_IN_US), i + 1 < num_phases ? "," : "");
+        } else {
+            printf(" %s%s", phases[i].name, i + 1 < num_phases ? "," : "");
+        }
+    }
+    if (timing) {
+        printf(" (%llu ms timed)", (unsigned long long)(total / NS_IN_MS));
+    }
+    printf("\n");
+}
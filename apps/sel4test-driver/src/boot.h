@@ -0,0 +1,24 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+/* Profile of the driver booting up to its first test. The phases are marked
+ * as they end, and timed once the timer is up: phases that end before then
+ * are listed without a time. */
+
+/* Most phases that can be marked */
+#define MAX_BOOT_PHASES 16
+
+struct driver_env;
+
+/* Start timing the boot phases, once the timer is up */
+void boot_start_timing(struct driver_env *env);
+
+/* Mark the end of a boot phase */
+void boot_phase_end(struct driver_env *env, const char *name);
+
+/* Print the boot phases and how long each took */
+void boot_print_profile(void);
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/util.h>
+
+#include "flaky.h"
+#include "runconfig.h"
+#include "test.h"
+
+typedef struct {
+    const char *name;
+    test_attempts_t attempts;
+} flaky_record_t;
+
+static flaky_record_t *records;
+static int num_records;
+static int max_records;
+
+static test_flaky_t *find_flaky(driver_env_t env, testcase_t *test)
+{
+    for (int i = 0; i < env->num_test_flaky; i++) {
+        if (strncmp(env->test_flaky[i].name, test->name, TEST_NAME_MAX) == 0) {
+            return &env->test_flaky[i];
+        }
+    }
+    return NULL;
+}
+
+int flaky_retries(driver_env_t env, testcase_t *test)
+{
+    test_flaky_t *flaky = find_flaky(env, test);
+    return flaky != NULL ? MAX(flaky->retries, run_config.retries) : run_config.retries;
+}
+
+bool flaky_is_quarantined(driver_env_t env, testcase_t *test)
+{
+    return run_config.quarantine && find_flaky(env, test) != NULL;
+}
+
+bool flaky_attempt(driver_env_t env, testcase_t *test, test_attempts_t *attempts, test_result_t result)
+{
+    attempts->attempts++;
+    if (result == SUCCESS) {
+        attempts->passes++;
+        return false;
+    }
+
+    /* an abort stops the run, whatever the test */
+    if (result != ABORT && attempts->attempts <= flaky_retries(env, test)) {
+        printf("%s failed attempt %d, retrying\n", test->name, attempts->attempts);
+        return true;
+    }
+    attempts->quarantined = result != ABORT && flaky_is_quarantined(env, test);
+    return false;
+}
+
+void flaky_init(int num_tests)
+{
+    records = calloc(num_tests, sizeof(flaky_record_t));
+    ZF_LOGF_IF(num_tests > 0 && records == NULL, "Failed to allocate test attempts");
+    max_records = num_tests;
+    num_records = 0;
+}
+
+void flaky_record(const char *name, test_attempts_t *attempts)
+{
+    if (attempts->attempts <= 1 && !attempts->quarantined) {
+        return;
+    }
+    if (num_records == max_records) {
+        /* more tests can be recorded than were counted at boot */
+        int max = MAX(2 * max_records, 16);
+        flaky_record_t *more = realloc(records, max * sizeof(flaky_record_t));
+        ZF_LOGF_IF(more == NULL, "Failed to allocate test attempts");
+        records = more;
+        max_records = max;
+    }
+    records[num_records].name = name;
+    records[num_records].attempts = *attempts;
+    num_records++;
+}
+
+int flaky_print_summary(void)
+{
+    int quarantined = 0;
+
+    if (num_records > 0) {
+        printf("Tests that needed more than one attempt:\n");
+    }
+    for (int i = 0; i < num_records; i++) {
+        test_attempts_t *attempts = &records[i].attempts;
+        printf("  %-24s passed %d of %d attempts (%d%%)%s\n", records[i].name, attempts->passes,
+               attempts->attempts, attempts->passes * 100 / attempts->attempts,
+               attempts->quarantined ? ", quarantined" : "");
+        quarantined += attempts->quarantined;
+    }
+
+    free(records);
+    records = NULL;
+    num_records = 0;
+    max_records = 0;
+    return quarantined;
+}
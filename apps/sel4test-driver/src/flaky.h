@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include <sel4test/test.h>
+
+/* Tests that fail are run again, up to the number of retries in the run
+ * config, or set for the test with DEFINE_TEST_FLAKY. If the run config turns
+ * quarantining on, tests defined with DEFINE_TEST_FLAKY are also quarantined:
+ * if every attempt fails they are reported as quarantined rather than failing
+ * the run. */
+
+/* attempts made at the current test */
+typedef struct test_attempts {
+    int attempts;
+    int passes;
+    /* every attempt failed, but the test is quarantined */
+    bool quarantined;
+} test_attempts_t;
+
+struct driver_env;
+
+/* Number of times to run a test again after it fails */
+int flaky_retries(struct driver_env *env, testcase_t *test);
+
+/* Whether failures of a test are reported without failing the run */
+bool flaky_is_quarantined(struct driver_env *env, testcase_t *test);
+
+/* Count an attempt at a test. Returns true if the test should be run again. */
+bool flaky_attempt(struct driver_env *env, testcase_t *test, test_attempts_t *attempts, test_result_t result);
+
+/* Make room to keep the attempts of num_tests tests, more room is made if
+ * more are recorded */
+void flaky_init(int num_tests);
+
+/* Keep the attempts at a test for the summary, if it needed more than one or
+ * was quarantined */
+void flaky_record(const char *name, test_attempts_t *attempts);
+
+/* Print the tests that needed more than one attempt or were quarantined.
+ * Returns the number of tests that were quarantined. */
+int flaky_print_summary(void);
@@ -14,6 +14,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include <sel4runtime.h>
 
@@ -43,13 +44,24 @@
 #include <vka/capops.h>
 
 #include <vspace/vspace.h>
+#include "boot.h"
+#include "parallel.h"
+#include "provision.h"
+#include "flaky.h"
+#include "registry.h"
+#include "runconfig.h"
+#include "service.h"
+#include "soak.h"
 #include "test.h"
 #include "timer.h"
+#include "timing.h"
+#include "usage.h"
 
 #include <sel4platsupport/io.h>
 
-/* ammount of untyped memory to reserve for the driver (32mb) */
-#define DRIVER_UNTYPED_MEMORY (1 << 25)
+/* ammount of untyped memory to reserve for the driver (32mb), plus 8mb for
+ * each process kept in the process pool and for each extra test slot */
+#define DRIVER_UNTYPED_MEMORY ((1 << 25) + (CONFIG_PROCESS_POOL_DEPTH + MAX_TEST_SLOTS - 1) * (1 << 23))
 /* Number of untypeds to try and use to allocate the driver memory.
  * if we cannot get 32mb with 16 untypeds then something is probably wrong */
 #define DRIVER_NUM_UNTYPEDS 16
@@ -67,9 +79,7 @@ static sel4utils_alloc_data_t data;
 /* environment encapsulating allocation interfaces etc */
 struct driver_env env;
 /* list of untypeds to give out to test processes */
-static vka_object_t untypeds[CONFIG_MAX_NUM_BOOTINFO_UNTYPED_CAPS];
-/* list of sizes (in bits) corresponding to untyped */
-static uint8_t untyped_size_bits_list[CONFIG_MAX_NUM_BOOTINFO_UNTYPED_CAPS];
+static vka_object_t untypeds[CONFIG_MAX_TEST_UNTYPEDS];
 
 extern char _cpio_archive[];
 extern char _cpio_archive_end[];
@@ -125,6 +135,41 @@ static void free_objects(vka_object_t *objects, unsigned int num)
     }
 }
 
+/* Memory in the boot info untypeds that is not device memory */
+static seL4_Word boot_ram_bytes(void)
+{
+    seL4_Word bytes = 0;
+    int untyped_count = simple_get_untyped_count(&env.simple);
+    for (int i = 0; i < untyped_count; i++) {
+        bool device = false;
+        uintptr_t ut_paddr = 0;
+        size_t ut_size_bits = 0;
+        simple_get_nth_untyped(&env.simple, i, &ut_size_bits, &ut_paddr, &device);
+        if (!device) {
+            bytes += BIT(ut_size_bits);
+        }
+    }
+    return bytes;
+}
+
+/* Size of the largest untyped in the boot info that is not device memory.
+ * The allocator cannot hand out anything larger. */
+static uint8_t max_untyped_size_bits(void)
+{
+    size_t max_size_bits = PAGE_BITS_4K;
+    int untyped_count = simple_get_untyped_count(&env.simple);
+    for (int i = 0; i < untyped_count; i++) {
+        bool device = false;
+        uintptr_t ut_paddr = 0;
+        size_t ut_size_bits = 0;
+        simple_get_nth_untyped(&env.simple, i, &ut_size_bits, &ut_paddr, &device);
+        if (!device) {
+            max_size_bits = MAX(max_size_bits, ut_size_bits);
+        }
+    }
+    return MIN(max_size_bits, seL4_WordBits - 1);
+}
+
 /* Allocate untypeds till either a certain number of bytes is allocated
  * or a certain number of untyped objects */
 static unsigned int allocate_untypeds(vka_object_t *untypeds, size_t bytes, unsigned int max_untypeds)
@@ -132,8 +177,10 @@ static unsigned int allocate_untypeds(vka_object_t *untypeds, size_t bytes, unsi
     unsigned int num_untypeds = 0;
     size_t allocated = 0;
 
-    /* try to allocate as many of each possible untyped size as possible */
-    for (uint8_t size_bits = seL4_WordBits - 1; size_bits > PAGE_BITS_4K; size_bits--) {
+    /* try to allocate as many of each possible untyped size as possible,
+     * starting from the largest there can be rather than failing to allocate
+     * every size down to it */
+    for (uint8_t size_bits = max_untyped_size_bits(); size_bits > PAGE_BITS_4K; size_bits--) {
         /* keep allocating until we run out, or if allocating would
          * cause us to allocate too much memory*/
         while (num_untypeds < max_untypeds &&
@@ -154,11 +201,7 @@ static unsigned int populate_untypeds(vka_object_t *untypeds)
     unsigned int reserve_num = allocate_untypeds(reserve, DRIVER_UNTYPED_MEMORY, DRIVER_NUM_UNTYPEDS);
 
     /* Now allocate everything else for the tests */
-    unsigned int num_untypeds = allocate_untypeds(untypeds, UINT_MAX, ARRAY_SIZE(untyped_size_bits_list));
-    /* Fill out the size_bits list */
-    for (unsigned int i = 0; i < num_untypeds; i++) {
-        untyped_size_bits_list[i] = untypeds[i].size_bits;
-    }
+    unsigned int num_untypeds = allocate_untypeds(untypeds, SIZE_MAX, ARRAY_SIZE(untypeds));
 
     /* Return reserve memory */
     free_objects(reserve, reserve_num);
@@ -171,6 +214,68 @@ static unsigned int populate_untypeds(vka_object_t *untypeds)
     return num_untypeds;
 }
 
+/* Index the untypeds of a pool by size, so that finding one of a size does
+ * not mean walking every untyped of the pool. The untypeds of a pool are in
+ * decreasing size, so each size is a run of the list. */
+static void index_untyped_pool(untyped_pool_t *pool)
+{
+    pool->bytes = 0;
+    for (int bits = 0; bits < seL4_WordBits; bits++) {
+        pool->first_of_size[bits] = 0;
+        pool->num_of_size[bits] = 0;
+    }
+    for (int i = 0; i < pool->num_untypeds; i++) {
+        int bits = pool->untypeds[i].size_bits;
+        ZF_LOGF_IF(i > 0 && bits > pool->untypeds[i - 1].size_bits, "Untypeds of pool not sorted by size");
+        if (pool->num_of_size[bits] == 0) {
+            pool->first_of_size[bits] = i;
+        }
+        pool->num_of_size[bits]++;
+        pool->bytes += BIT(bits);
+    }
+}
+
+/* Split the untypeds for tests between the untyped pools. Untypeds are dealt
+ * out in turn, and as they are sorted by size this gives each pool a similar
+ * amount of memory. Each pool ends up as a contiguous part of the list. */
+static void init_untyped_pools(int num_pools)
+{
+    static vka_object_t dealt[CONFIG_MAX_TEST_UNTYPEDS];
+    int num_dealt = 0;
+
+    for (int p = 0; p < num_pools; p++) {
+        untyped_pool_t *pool = &env.untyped_pools[p];
+        pool->untypeds = &env.untypeds[num_dealt];
+        for (int i = p; i < env.num_untypeds; i += num_pools) {
+            dealt[num_dealt++] = env.untypeds[i];
+        }
+        pool->num_untypeds = &env.untypeds[num_dealt] - pool->untypeds;
+        ZF_LOGF_IF(pool->num_untypeds == 0, "Not enough untypeds for %d pools", num_pools);
+
+        if (num_pools > 1) {
+            int error = vka_alloc_notification(&env.vka, &pool->reclaimed);
+            ZF_LOGF_IF(error, "Failed to allocate notification for untyped pool");
+        }
+    }
+
+    size_t total_bytes = 0;
+    for (int i = 0; i < num_dealt; i++) {
+        env.untypeds[i] = dealt[i];
+        total_bytes += BIT(dealt[i].size_bits);
+    }
+
+    /* the pools point into the list, so they can only be indexed once the
+     * dealt untypeds are back in it */
+    size_t pool_bytes = 0;
+    for (int p = 0; p < num_pools; p++) {
+        index_untyped_pool(&env.untyped_pools[p]);
+        pool_bytes += env.untyped_pools[p].bytes;
+    }
+    ZF_LOGF_IF(pool_bytes != total_bytes, "Untyped pools hold %zu bytes, not the %zu bytes of their untypeds",
+               pool_bytes, total_bytes);
+    env.num_untyped_pools = num_pools;
+}
+
 static void init_timer(void)
 {
     if (config_set(CONFIG_HAVE_TIMER)) {
@@ -187,47 +292,126 @@ static void init_timer(void)
         ZF_LOGF_IF(error, "Failed to bind timer notification to sel4test-driver");
 
         /* set up the timer manager */
-        tm_init(&env.tm, &env.ltimer, &env.ops, 1);
+        /* each test slot has a timer for its tests and a watchdog */
+        tm_init(&env.tm, &env.ltimer, &env.ops, 2 * env.num_test_slots);
+        watchdog_init(&env);
     }
 }
 
 void sel4test_start_suite(const char *name)
 {
-    if (config_set(CONFIG_PRINT_XML)) {
+    if (run_config.print_xml) {
         printf("<testsuite>\n");
     } else {
         printf("Starting test suite %s\n", name);
     }
 }
 
+/* name of the test being run */
+static const char *current_test;
+
+/* Open the properties element of a testcase, before its first property */
+static void start_properties(bool *started)
+{
+    if (!*started) {
+        printf("\t\t<properties>\n");
+        *started = true;
+    }
+}
+
 void sel4test_start_test(const char *name, int n)
 {
-    if (config_set(CONFIG_PRINT_XML)) {
-        printf("\t<testcase classname=\"%s\" name=\"%s\">\n", "sel4test", name);
-    } else {
+    /* the testcase element is opened once the time of the test is known */
+    if (!run_config.print_xml) {
         printf("Starting test %d: %s\n", n, name);
     }
+    current_test = name;
+    memset(&env.timing, 0, sizeof(env.timing));
+    memset(&env.attempts, 0, sizeof(env.attempts));
+    memset(&env.service, 0, sizeof(env.service));
+    env.have_usage = false;
     sel4test_reset();
     sel4test_start_printf_buffer();
 }
 
 void sel4test_end_test(test_result_t result)
 {
+    test_timing_t *timing = &env.timing;
+    uint64_t total = timing_total(timing);
+    test_attempts_t *attempts = &env.attempts;
+
+    if (run_config.print_xml) {
+        printf("\t<testcase classname=\"%s\" name=\"%s\"", "sel4test", current_test);
+        if (timing->timed) {
+            printf(" time=\"%llu.%06llu\"", (unsigned long long)(total / NS_IN_S),
+                   (unsigned long long)(total % NS_IN_S / NS_IN_US));
+        }
+        printf(">\n");
+        bool properties = false;
+        if (timing->timed) {
+            start_properties(&properties);
+            printf("\t\t\t<property name=\"set_up_us\" value=\"%llu\"/>\n",
+                   (unsigned long long)(timing->phase_ns[PHASE_SET_UP] / NS_IN_US));
+            printf("\t\t\t<property name=\"run_us\" value=\"%llu\"/>\n",
+                   (unsigned long long)(timing->phase_ns[PHASE_RUN] / NS_IN_US));
+            printf("\t\t\t<property name=\"tear_down_us\" value=\"%llu\"/>\n",
+                   (unsigned long long)(timing->phase_ns[PHASE_TEAR_DOWN] / NS_IN_US));
+        }
+        if (env.have_usage) {
+            start_properties(&properties);
+            usage_print(current_test, &env.usage, true);
+        }
+        if (attempts->attempts > 1 && !attempts->quarantined) {
+            start_properties(&properties);
+            printf("\t\t\t<property name=\"attempts\" value=\"%d\"/>\n", attempts->attempts);
+            printf("\t\t\t<property name=\"passes\" value=\"%d\"/>\n", attempts->passes);
+        }
+        if (properties) {
+            printf("\t\t</properties>\n");
+        }
+    } else if (timing->timed) {
+        printf("%s took %llu us (set up %llu, run %llu, tear down %llu)\n", current_test,
+               (unsigned long long)(total / NS_IN_US),
+               (unsigned long long)(timing->phase_ns[PHASE_SET_UP] / NS_IN_US),
+               (unsigned long long)(timing->phase_ns[PHASE_RUN] / NS_IN_US),
+               (unsigned long long)(timing->phase_ns[PHASE_TEAR_DOWN] / NS_IN_US));
+    }
+    timing_record(current_test, timing);
+    soak_record(current_test, timing, env.have_usage ? &env.usage : NULL);
+    service_record(current_test, &env.service, run_config.print_xml);
+    if (env.have_usage && !run_config.print_xml) {
+        usage_print(current_test, &env.usage, false);
+    }
+
+    flaky_record(current_test, attempts);
+    if (attempts->quarantined) {
+        if (run_config.print_xml) {
+            printf("\t\t<skipped message=\"quarantined, failed %d attempts\"/>\n", attempts->attempts);
+        } else {
+            printf("QUARANTINED: %s failed %d attempts\n", current_test, attempts->attempts);
+        }
+        /* the failure is reported, but does not fail the run */
+        sel4test_reset();
+    } else if (attempts->attempts > 1 && !run_config.print_xml) {
+        printf("%s passed %d of %d attempts\n", current_test, attempts->passes, attempts->attempts);
+    }
+
     sel4test_end_printf_buffer();
     test_check(result == SUCCESS);
 
-    if (config_set(CONFIG_PRINT_XML)) {
+    if (run_config.print_xml) {
         printf("\t</testcase>\n");
     }
 
-    if (config_set(CONFIG_HAVE_TIMER)) {
+    /* tests running in parallel have their timers reset when they finish */
+    if (config_set(CONFIG_HAVE_TIMER) && !env.in_parallel) {
         timer_reset(&env);
     }
 }
 
 void sel4test_end_suite(int num_tests, int num_tests_passed, int skipped_tests)
 {
-    if (config_set(CONFIG_PRINT_XML)) {
+    if (run_config.print_xml) {
         printf("</testsuite>\n");
     } else {
         if (num_tests_passed != num_tests) {
@@ -246,7 +430,7 @@ void sel4test_stop_tests(test_result_t result, int tests_done, int tests_failed,
         printf("Halting on fatal assertion...\n");
         break;
     case FAILURE:
-        assert(config_set(CONFIG_TESTPRINTER_HALT_ON_TEST_FAILURE));
+        assert(run_config.halt_on_failure);
         printf("Halting on first test failure\n");
         break;
     default:
@@ -265,6 +449,15 @@ void sel4test_stop_tests(test_result_t result, int tests_done, int tests_failed,
     sel4test_end_test(sel4test_get_result());
 
     sel4test_end_suite(tests_done, tests_done - tests_failed, skipped_tests);
+    timing_print_summary();
+    service_print_summary();
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        timer_print_irq_summary();
+    }
+    int quarantined = flaky_print_summary();
+    if (quarantined > 0) {
+        printf("%d quarantined tests failed, which does not fail the run\n", quarantined);
+    }
 
     if (tests_failed > 0) {
         printf("*** FAILURES DETECTED ***\n");
@@ -276,23 +469,117 @@ void sel4test_stop_tests(test_result_t result, int tests_done, int tests_failed,
     printf("\n\n");
 }
 
-static int collate_tests(testcase_t *tests_in, int n, testcase_t *tests_out[], int out_index,
-                         regex_t *reg, int *skipped_tests)
+/* Place the tests of a section at their position in the test registry */
+static void register_tests(testcase_t *tests_in, int n, testcase_t *tests_out[], int *skipped_tests)
 {
     for (int i = 0; i < n; i++) {
         /* make sure the string is null terminated */
         tests_in[i].name[TEST_NAME_MAX - 1] = '\0';
-        if (regexec(reg, tests_in[i].name, 0, NULL, 0) == 0) {
-            if (tests_in[i].enabled) {
-                tests_out[out_index] = &tests_in[i];
-                out_index++;
-            } else {
-                (*skipped_tests)++;
+        int index = test_registry_lookup(tests_in[i].name);
+        if (index < 0) {
+            continue;
+        }
+        ZF_LOGF_IF(tests_out[index] != NULL, "tests have no strict order! %s", tests_in[i].name);
+        /* disabled tests take their slot too, so that duplicates are caught */
+        tests_out[index] = &tests_in[i];
+        if (!tests_in[i].enabled) {
+            (*skipped_tests)++;
+        }
+    }
+}
+
+/* Compare tests by the cost table of the registry, for run_config.order.
+ * Ties keep the registry order, so the order only changes with the table. */
+static int test_cost_comparator(const void *a, const void *b)
+{
+    int index_a = test_registry_lookup((*(testcase_t *const *) a)->name);
+    int index_b = test_registry_lookup((*(testcase_t *const *) b)->name);
+
+    if (run_config.order == TEST_ORDER_LONGEST && test_registry_cost(index_a) != test_registry_cost(index_b)) {
+        return test_registry_cost(index_a) > test_registry_cost(index_b) ? -1 : 1;
+    }
+    if (run_config.order == TEST_ORDER_FAILED &&
+        test_registry_failed_before(index_a) != test_registry_failed_before(index_b)) {
+        return test_registry_failed_before(index_a) ? -1 : 1;
+    }
+    return index_a - index_b;
+}
+
+/* Order the selected tests by run_config.order, before they are dealt out to
+ * the shards: dealing the longest tests out first evens out the shards. The
+ * order is printed so that a run can be reproduced. */
+static void order_by_cost(testcase_t *tests[], int num_tests)
+{
+    if (run_config.order != TEST_ORDER_DEFAULT) {
+        qsort(tests, num_tests, sizeof(testcase_t *), test_cost_comparator);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < num_tests; i++) {
+        failed += test_registry_failed_before(test_registry_lookup(tests[i]->name));
+    }
+    printf("Test order: %s, cost table has times of %d tests, %d of the selected tests failed before\n",
+           run_config_order_name(run_config.order), test_registry_costs_known(), failed);
+}
+
+/* Keep the tests of this shard. The tests are dealt out to the shards in the
+ * order they run, so every shard gets a similar mix of test types, and the
+ * shard of a test only changes when the tests selected change. Returns the
+ * number of tests kept. */
+static int select_shard(testcase_t *tests[], int num_selected)
+{
+    int num_tests = 0;
+    for (int i = run_config.shard_index; i < num_selected; i += run_config.shard_count) {
+        tests[num_tests] = tests[i];
+        num_tests++;
+    }
+
+    /* lets the logs of all the shards be checked to cover every test once */
+    if (run_config.shard_count > 1) {
+        printf("Shard %d/%d: %d of %d tests\n", run_config.shard_index, run_config.shard_count, num_tests,
+               num_selected);
+    }
+    return num_tests;
+}
+
+/* Put the tests in the order they run: by test type, and in the order they
+ * were selected within each type. Tests of a type that was not declared go
+ * last, so that they are still found missing at the end of the run. */
+static void order_by_test_type(testcase_t *tests[], int num_tests, struct test_type *test_types[],
+                               int num_test_types)
+{
+    testcase_t **ordered = malloc(sizeof(testcase_t *) * num_tests);
+    ZF_LOGF_IF(num_tests > 0 && ordered == NULL, "Failed to allocate ordered tests");
+
+    int n = 0;
+    for (int tt = 0; tt <= num_test_types; tt++) {
+        for (int i = 0; i < num_tests; i++) {
+            int type = 0;
+            while (type < num_test_types && test_types[type]->id != tests[i]->test_type) {
+                type++;
+            }
+            if (type == tt) {
+                ordered[n] = tests[i];
+                n++;
             }
         }
     }
+    memcpy(tests, ordered, sizeof(testcase_t *) * num_tests);
+    free(ordered);
+}
 
-    return out_index;
+/* Keep the tests from run_config.start_index up to before
+ * run_config.end_index, counted in the order the tests run. The range is
+ * printed so that scripts/relaunch.py can resume a run that crashed after the
+ * test that crashed it. Returns the number of tests kept. */
+static int select_range(testcase_t *tests[], int num_tests)
+{
+    int end = run_config.end_index != 0 ? MIN(run_config.end_index, num_tests) : num_tests;
+    int start = MIN(run_config.start_index, end);
+
+    memmove(tests, tests + start, sizeof(testcase_t *) * (end - start));
+    printf("Running tests %d to %d of %d\n", start, end, num_tests);
+    return end - start;
 }
 
 void sel4test_run_tests(struct driver_env *e)
@@ -309,7 +596,7 @@ void sel4test_run_tests(struct driver_env *e)
     /* Ensure we iterate through test types in order of ID. */
     qsort(test_types, num_test_types, sizeof(struct test_type *), test_type_comparator);
 
-    /* Count how many tests actually exist and allocate space for them */
+    /* Find the test sections of the driver and the tests image */
     int driver_tests = (int)(__stop__test_case - __start__test_case);
     uint64_t tc_size = 0;
     testcase_t *sel4test_tests = (testcase_t *) sel4utils_elf_get_section(&tests_elf, "_test_case", &tc_size);
@@ -317,33 +604,75 @@ void sel4test_run_tests(struct driver_env *e)
         ZF_LOGF(TESTS_APP": Failed to find section: _test_case");
     }
     int tc_tests = tc_size / sizeof(testcase_t);
-    int all_tests = driver_tests + tc_tests;
-    testcase_t *tests[all_tests];
-
-    /* Extract and filter the tests based on the regex */
-    regex_t reg;
-    int error = regcomp(&reg, CONFIG_TESTPRINTER_REGEX, REG_EXTENDED | REG_NOSUB);
-    ZF_LOGF_IF(error, "Error compiling regex \"%s\"", CONFIG_TESTPRINTER_REGEX);
+    e->test_cases = sel4test_tests;
+    uint64_t deadlines_size = 0;
+    e->test_deadlines = (test_deadline_t *) sel4utils_elf_get_section(&tests_elf, "_test_deadline",
+                                                                      &deadlines_size);
+    e->num_test_deadlines = e->test_deadlines != NULL ? deadlines_size / sizeof(test_deadline_t) : 0;
+    uint64_t flaky_size = 0;
+    e->test_flaky = (test_flaky_t *) sel4utils_elf_get_section(&tests_elf, "_test_flaky", &flaky_size);
+    e->num_test_flaky = e->test_flaky != NULL ? flaky_size / sizeof(test_flaky_t) : 0;
+
+    /* The registry holds the selected tests in the order they run. Tests that
+     * are not in either image leave a gap. */
+    int registry_size = test_registry_size();
+    testcase_t *tests[registry_size + 1];
+    memset(tests, 0, sizeof(tests));
 
     int skipped_tests = 0;
     /* get all the tests in the test case section in the driver */
-    int num_tests = collate_tests(__start__test_case, driver_tests, tests, 0, &reg, &skipped_tests);
+    register_tests(__start__test_case, driver_tests, tests, &skipped_tests);
     /* get all the tests in the sel4test_tests app */
-    num_tests = collate_tests(sel4test_tests, tc_tests, tests, num_tests, &reg, &skipped_tests);
+    register_tests(sel4test_tests, tc_tests, tests, &skipped_tests);
+
+    /* the run config can narrow down the tests further */
+    regex_t reg;
+    regex_t *filter = NULL;
+    if (run_config.regex != NULL) {
+        int error = regcomp(&reg, run_config.regex, REG_EXTENDED | REG_NOSUB);
+        ZF_LOGF_IF(error, "Error compiling regex \"%s\"", run_config.regex);
+        filter = &reg;
+    }
 
-    /* finished with regex */
-    regfree(&reg);
+    /* drop the gaps and the disabled tests */
+    int num_selected = 0;
+    for (int i = 0; i < registry_size; i++) {
+        if (tests[i] == NULL || !tests[i]->enabled) {
+            continue;
+        }
+        if (filter != NULL && regexec(filter, tests[i]->name, 0, NULL, 0) != 0) {
+            continue;
+        }
+        tests[num_selected] = tests[i];
+        num_selected++;
+    }
+    if (filter != NULL) {
+        regfree(filter);
+    }
 
-    /* Sort the tests to remove any non determinism in test ordering */
-    qsort(tests, num_tests, sizeof(testcase_t *), test_comparator);
+    order_by_cost(tests, num_selected);
+    int num_tests = select_shard(tests, num_selected);
 
-    /* Now that they are sorted we can easily ensure there are no duplicate tests.
-     * this just ensures some sanity as if there are duplicates, they could have some
-     * arbitrary ordering, which might result in difficulty reproducing test failures */
-    for (int i = 1; i < num_tests; i++) {
-        ZF_LOGF_IF(strcmp(tests[i]->name, tests[i - 1]->name) == 0, "tests have no strict order! %s %s",
-                   tests[i]->name, tests[i - 1]->name);
+    /* each test runs repeat times in a row */
+    testcase_t **run = tests;
+    if (run_config.repeat > 1) {
+        run = malloc(sizeof(testcase_t *) * num_tests * run_config.repeat);
+        ZF_LOGF_IF(run == NULL, "Failed to allocate repeated tests");
+        for (int i = 0; i < num_tests * run_config.repeat; i++) {
+            run[i] = tests[i / run_config.repeat];
+        }
+        num_tests *= run_config.repeat;
     }
+    order_by_test_type(run, num_tests, test_types, num_test_types);
+    num_tests = select_range(run, num_tests);
+
+    timing_init(num_tests);
+    service_init(num_tests);
+    flaky_init(num_tests);
+    soak_init(num_tests);
+
+    boot_phase_end(e, "test selection");
+    boot_print_profile();
 
     /* Check that we don't miss any tests because of an undeclared test type */
     int tests_done = 0;
@@ -356,47 +685,82 @@ void sel4test_run_tests(struct driver_env *e)
     sel4test_end_test(sel4test_get_result());
     tests_done++;
 
-    /* Iterate through test types so that we run them in order of test type, then name.
-       * Test types are ordered by ID in test.h. */
-    for (int tt = 0; tt < num_test_types; tt++) {
-        /* set up */
-        if (test_types[tt]->set_up_test_type != NULL) {
-            test_types[tt]->set_up_test_type((uintptr_t)e);
-        }
-
-        for (int i = 0; i < num_tests; i++) {
-            if (tests[i]->test_type == test_types[tt]->id) {
-                sel4test_start_test(tests[i]->name, tests_done);
-                if (test_types[tt]->set_up != NULL) {
-                    test_types[tt]->set_up((uintptr_t)e);
-                }
-
-                test_result_t result = test_types[tt]->run_test(tests[i], (uintptr_t)e);
+    /* tests expected to run, over every soak iteration so far */
+    int num_expected = 0;
+    do {
+        num_expected += num_tests;
+        soak_start_iteration(e);
+
+        /* Iterate through test types so that we run them in order of test type, then name.
+           * Test types are ordered by ID in test.h. */
+        for (int tt = 0; tt < num_test_types; tt++) {
+            /* set up */
+            if (test_types[tt]->set_up_test_type != NULL) {
+                test_types[tt]->set_up_test_type((uintptr_t)e);
+            }
 
-                if (test_types[tt]->tear_down != NULL) {
-                    test_types[tt]->tear_down((uintptr_t)e);
+            /* BASIC tests may be run in parallel instead of one at a time */
+            bool ran_in_parallel = false;
+#ifdef CONFIG_PARALLEL_TESTS
+            if (test_types[tt]->id == BASIC) {
+                test_result_t result = parallel_run_tests(e, test_types[tt], run, num_tests, &tests_done,
+                                                          &tests_failed);
+                if (result != SUCCESS) {
+                    sel4test_stop_tests(result, tests_done + 1, tests_failed, num_expected + 1, skipped_tests);
+                    return;
                 }
-                sel4test_end_test(result);
+                ran_in_parallel = true;
+            }
+#endif
 
-                if (result != SUCCESS) {
-                    tests_failed++;
-                    if (config_set(CONFIG_TESTPRINTER_HALT_ON_TEST_FAILURE) || result == ABORT) {
-                        sel4test_stop_tests(result, tests_done + 1, tests_failed, num_tests + 1, skipped_tests);
-                        return;
+            for (int i = 0; i < num_tests && !ran_in_parallel; i++) {
+                if (run[i]->test_type == test_types[tt]->id) {
+                    sel4test_start_test(run[i]->name, tests_done);
+                    timing_start(e, &e->timing);
+                    test_result_t result;
+                    do {
+                        /* a failed attempt is not held against the next one */
+                        sel4test_reset();
+                        if (test_types[tt]->set_up != NULL) {
+                            test_types[tt]->set_up((uintptr_t)e);
+                        }
+                        timing_end_phase(e, &e->timing, PHASE_SET_UP);
+
+                        result = test_types[tt]->run_test(run[i], (uintptr_t)e);
+                        timing_end_phase(e, &e->timing, PHASE_RUN);
+
+                        if (test_types[tt]->tear_down != NULL) {
+                            test_types[tt]->tear_down((uintptr_t)e);
+                        }
+                        timing_end_phase(e, &e->timing, PHASE_TEAR_DOWN);
+                    } while (flaky_attempt(e, run[i], &e->attempts, result));
+                    if (e->attempts.quarantined) {
+                        result = SUCCESS;
+                    }
+                    sel4test_end_test(result);
+
+                    if (result != SUCCESS) {
+                        tests_failed++;
+                        if (run_config.halt_on_failure || result == ABORT) {
+                            sel4test_stop_tests(result, tests_done + 1, tests_failed, num_expected + 1, skipped_tests);
+                            return;
+                        }
                     }
+                    tests_done++;
                 }
-                tests_done++;
             }
-        }
 
-        /* tear down */
-        if (test_types[tt]->tear_down_test_type != NULL) {
-            test_types[tt]->tear_down_test_type((uintptr_t)e);
+            /* tear down */
+            if (test_types[tt]->tear_down_test_type != NULL) {
+                test_types[tt]->tear_down_test_type((uintptr_t)e);
+            }
         }
-    }
+
+        soak_end_iteration(e);
+    } while (soak_continue(e));
 
     /* and we're done */
-    sel4test_stop_tests(SUCCESS, tests_done, tests_failed, num_tests + 1, skipped_tests);
+    sel4test_stop_tests(SUCCESS, tests_done, tests_failed, num_expected + 1, skipped_tests);
 }
 
 void *main_continued(void *arg UNUSED)
@@ -413,6 +777,10 @@ void *main_continued(void *arg UNUSED)
     int status = elf_newFile(elf_file, elf_size, &tests_elf);
     ZF_LOGF_IF(status, "Error: invalid ELF file");
 
+    /* the run config may override the build config for this run */
+    run_config_init(&env, _cpio_archive, cpio_len);
+    boot_phase_end(&env, "stack and run config");
+
     /* Print welcome banner. */
     printf("\n");
     printf("seL4 Test\n");
@@ -442,18 +810,26 @@ void *main_continued(void *arg UNUSED)
         }
         ZF_LOGF_IF(allocated == false, "Failed to allocate a device frame for the frame tests");
     }
+    boot_phase_end(&env, "device frame");
 
     /* allocate lots of untyped memory for tests to use */
     env.num_untypeds = populate_untypeds(untypeds);
     env.untypeds = untypeds;
+    /* tests take turns with the pools while the worker reclaims the others,
+     * or when running in parallel each test slot has its own pool */
+    if (config_set(CONFIG_PARALLEL_TESTS)) {
+        init_untyped_pools(env.num_test_slots);
+    } else {
+        init_untyped_pools(config_set(CONFIG_BACKGROUND_TEARDOWN) ? MAX_UNTYPED_POOLS : 1);
+    }
+    boot_phase_end(&env, "untypeds");
 
     /* create a frame that will act as the init data, we can then map that
      * in to target processes */
-    env.init = (test_init_data_t *) vspace_new_pages(&env.vspace, seL4_AllRights, 1, PAGE_BITS_4K);
+    env.init = (test_init_data_t *) vspace_new_pages(&env.vspace, seL4_AllRights, TEST_INIT_DATA_PAGES,
+                                                     PAGE_BITS_4K);
     assert(env.init != NULL);
-
-    /* copy the untyped size bits list across to the init frame */
-    memcpy(env.init->untyped_size_bits_list, untyped_size_bits_list, sizeof(uint8_t) * env.num_untypeds);
+    env.init->total_ram_bytes = boot_ram_bytes();
 
     /* parse elf region data about the test image to pass to the tests app */
     num_elf_regions = sel4utils_elf_num_regions(&tests_elf);
@@ -463,18 +839,31 @@ void *main_continued(void *arg UNUSED)
     /* copy the region list for the process to clone itself */
     memcpy(env.init->elf_regions, elf_regions, sizeof(sel4utils_elf_region_t) * num_elf_regions);
     env.init->num_elf_regions = num_elf_regions;
+    if (config_set(CONFIG_REPORT_SPAWN_TIME)) {
+        size_t loaded = 0;
+        for (int i = 0; i < num_elf_regions; i++) {
+            loaded += elf_regions[i].size;
+        }
+        printf(TESTS_APP " image is %lu KiB, %zu KiB loaded in %d regions\n", elf_size / 1024, loaded / 1024,
+               num_elf_regions);
+    }
 
     /* setup init data that won't change test-to-test */
     env.init->priority = seL4_MaxPrio - 1;
     if (plat_init) {
         plat_init(&env);
     }
+    provision_init(&env);
+#ifdef CONFIG_PARALLEL_TESTS
+    parallel_init(&env);
+#endif
 
     /* Allocate a reply object for the RT kernel. */
     if (config_set(CONFIG_KERNEL_MCS)) {
         error = vka_alloc_reply(&env.vka, &env.reply);
         ZF_LOGF_IF(error, "Failed to allocate reply");
     }
+    boot_phase_end(&env, "init data");
 
     /* now run the tests */
     sel4test_run_tests(&env);
@@ -614,6 +1003,7 @@ int main(void)
      * manager, timer
      */
     init_env(&env);
+    boot_phase_end(&env, "init_env");
 
     /* Partially overwrite part of the VKA implementation to cache objects. We need to
      * create this wrapper as the actual vka implementation will only
@@ -634,6 +1024,7 @@ int main(void)
     serial_utspace_record = true;
     platsupport_serial_setup_simple(&env.vspace, &env.simple, &env.vka);
     serial_utspace_record = false;
+    boot_phase_end(&env, "serial");
 
     /* Partially overwrite the IRQ interface so that we can record the IRQ caps that were allocated.
      * We need this only for the timer as the ltimer interfaces allocates the caps for us and hides them away.
@@ -641,12 +1032,23 @@ int main(void)
      */
     irq_register_fn_copy = env.ops.irq_ops.irq_register_fn;
     env.ops.irq_ops.irq_register_fn = sel4test_timer_irq_register;
+    /* one test slot for each core when running tests in parallel */
+    env.num_test_slots = 1;
+#ifdef CONFIG_PARALLEL_TESTS
+    env.num_test_slots = MIN(simple_get_core_count(&env.simple), MAX_TEST_SLOTS);
+#endif
+
     /* Initialise ltimer */
     init_timer();
     /* Restore the IRQ interface's register function */
     env.ops.irq_ops.irq_register_fn = irq_register_fn_copy;
+    boot_phase_end(&env, "timer");
+    boot_start_timing(&env);
 
-    simple_print(&env.simple);
+    if (config_set(CONFIG_PRINT_BOOTINFO)) {
+        simple_print(&env.simple);
+        boot_phase_end(&env, "simple_print");
+    }
 
     /* switch to a bigger, safer stack with a guard page
      * before starting the tests */
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#ifdef CONFIG_PARALLEL_TESTS
+
+#include <assert.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sel4rpc/server.h>
+#include <sel4testsupport/testreporter.h>
+#include <utils/util.h>
+#include <vka/capops.h>
+
+#include "flaky.h"
+#include "parallel.h"
+#include "refill.h"
+#include "runconfig.h"
+#include "teardown.h"
+#include "timer.h"
+#include "worker.h"
+
+/* Messages from test processes have this bit set in their badge, with the test
+ * slot above it. The bits below are the badges of the timer IRQs. */
+#define TEST_BADGE_BIT BIT(MAX_TIMER_IRQS)
+#define TEST_BADGE(slot) (TEST_BADGE_BIT | ((seL4_Word)(slot) << (MAX_TIMER_IRQS + 1)))
+#define TEST_BADGE_SLOT(badge) ((int)((badge) >> (MAX_TIMER_IRQS + 1)))
+
+/* How many tests may be started ahead of the next test to report. This bounds
+ * the output held for tests that are waiting to be reported. */
+#define MAX_TESTS_AHEAD 64
+
+typedef enum {
+    TEST_WAITING,
+    TEST_RUNNING,
+    TEST_FINISHED,
+} run_state_t;
+
+/* A test to run, and what it left to report */
+typedef struct {
+    testcase_t *test;
+    run_state_t state;
+    /* the test must not run alongside other tests */
+    bool exclusive;
+    int result;
+    int slot;
+    test_timing_t timing;
+    test_attempts_t attempts;
+
+    /* copy of the output of the test */
+    char *output;
+    seL4_Word output_len;
+    bool truncated;
+
+    test_usage_t usage;
+    service_stats_t service;
+
+    /* the fault that ended the test. The process of a test that faulted is
+     * kept until the test is reported, so that its registers can be dumped. */
+    bool faulted;
+    seL4_MessageInfo_t fault_info;
+    seL4_Word fault_mrs[seL4_MsgMaxLength];
+    /* the test was stopped by the watchdog, its process is also kept */
+    bool timed_out;
+} run_entry_t;
+
+typedef struct {
+    /* test in the slot, NULL when the slot is free */
+    run_entry_t *entry;
+    test_process_t *process;
+    untyped_pool_t *pool;
+} test_slot_t;
+
+static test_slot_t slots[MAX_TEST_SLOTS];
+
+void parallel_init(driver_env_t env)
+{
+    int error = vka_alloc_endpoint(&env->vka, &env->parallel_endpoint);
+    ZF_LOGF_IF(error, "Failed to allocate endpoint for parallel tests");
+
+    /* slot 0 uses the timer notification of the tests */
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        for (int i = 1; i < env->num_test_slots; i++) {
+            error = vka_alloc_notification(&env->vka, &env->slot_timer_notify[i]);
+            ZF_LOGF_IF(error, "Failed to allocate timer notification for test slot %d", i);
+        }
+    }
+}
+
+/* Replace a cap in the cspace of a test process */
+static void replace_cap(driver_env_t env, test_process_t *test, seL4_CPtr slot, seL4_CPtr cap, seL4_Word badge)
+{
+    cspacepath_t src, dest = {
+        .root = test->process.cspace.cptr,
+        .capPtr = slot,
+        .capDepth = TEST_PROCESS_CSPACE_SIZE_BITS,
+    };
+    vka_cspace_make_path(&env->vka, cap, &src);
+    int error = vka_cnode_delete(&dest);
+    if (!error) {
+        error = vka_cnode_mint(&dest, &src, seL4_AllRights, badge);
+    }
+    ZF_LOGF_IF(error, "Failed to replace cap in test process");
+}
+
+void parallel_join_slot(driver_env_t env, test_process_t *test, int slot)
+{
+    /* the test reports to, and faults to, the endpoint of all the slots */
+    replace_cap(env, test, test->endpoint, env->parallel_endpoint.cptr, TEST_BADGE(slot));
+    replace_cap(env, test, SEL4UTILS_ENDPOINT_SLOT, env->parallel_endpoint.cptr, TEST_BADGE(slot));
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        replace_cap(env, test, test->init->timer_ntfn, timer_slot_notification(env, slot), 0);
+    }
+
+    int error = seL4_TCB_SetAffinity(test->process.thread.tcb.cptr, slot);
+    ZF_LOGF_IF(error, "Failed to move test process to core %d", slot);
+}
+
+/* Make the test in a slot the current test of the driver */
+static void select_slot(driver_env_t env, int slot)
+{
+    env->timer_slot = slot;
+    env->test = slots[slot].process;
+    env->test_untypeds = slots[slot].pool;
+}
+
+/* Find a slot for the next test, or -1 if it has to wait */
+static int find_slot(driver_env_t env, run_entry_t *entry)
+{
+    int free_slot = -1;
+    for (int i = env->num_test_slots - 1; i >= 0; i--) {
+        if (slots[i].entry == NULL) {
+            free_slot = i;
+        } else if (entry->exclusive || slots[i].entry->exclusive) {
+            return -1;
+        }
+    }
+    return free_slot;
+}
+
+static void start_test(driver_env_t env, struct test_type *type, run_entry_t *entry, int slot)
+{
+    env->timer_slot = slot;
+    /* retries add to the time of the test */
+    if (entry->attempts.attempts == 0) {
+        timing_start(env, &entry->timing);
+    } else {
+        timing_restart(env, &entry->timing);
+    }
+    type->set_up((uintptr_t)env);
+    timing_end_phase(env, &entry->timing, PHASE_SET_UP);
+    basic_start_test(env, entry->test);
+
+    slots[slot].entry = entry;
+    slots[slot].process = env->test;
+    slots[slot].pool = env->test_untypeds;
+    entry->state = TEST_RUNNING;
+    entry->slot = slot;
+
+    env->test = NULL;
+    env->test_untypeds = NULL;
+}
+
+/* Tear down the test in a slot, and free the slot */
+static void release_slot(driver_env_t env, struct test_type *type, int slot)
+{
+    test_timing_t *timing = &slots[slot].entry->timing;
+
+    select_slot(env, slot);
+    timing_restart(env, timing);
+    type->tear_down((uintptr_t)env);
+    timing_end_phase(env, timing, PHASE_TEAR_DOWN);
+    slots[slot].entry = NULL;
+}
+
+/* Keep a copy of what the current test printed */
+static void copy_output(driver_env_t env, run_entry_t *entry)
+{
+    test_output_t *remote = env->test->init->output;
+    if (remote == NULL) {
+        /* the test never got far enough to print anything */
+        return;
+    }
+
+    test_output_t *output = vspace_share_mem(&env->test->process.vspace, &env->vspace, remote, TEST_OUTPUT_PAGES,
+                                             PAGE_BITS_4K, seL4_CanRead, 1);
+    ZF_LOGF_IF(output == NULL, "Failed to map output of %s", entry->test->name);
+
+    entry->output_len = MIN(output->len, sizeof(output->data));
+    entry->truncated = output->truncated;
+    if (entry->output_len > 0) {
+        entry->output = malloc(entry->output_len);
+        ZF_LOGF_IF(entry->output == NULL, "Failed to allocate output of %s", entry->test->name);
+        memcpy(entry->output, output->data, entry->output_len);
+    }
+
+    vspace_unmap_pages(&env->vspace, output, TEST_OUTPUT_PAGES, PAGE_BITS_4K, &env->vka);
+}
+
+/* Print the fault or timeout that ended a test, from its kept process */
+static void print_end(run_entry_t *entry)
+{
+    if (entry->faulted) {
+        for (int i = 0; i < MIN(seL4_MessageInfo_get_length(entry->fault_info), seL4_MsgMaxLength); i++) {
+            seL4_SetMR(i, entry->fault_mrs[i]);
+        }
+        basic_print_fault(slots[entry->slot].process, entry->fault_info, entry->test->name);
+    } else if (entry->timed_out) {
+        basic_print_timeout(slots[entry->slot].process, entry->test->name);
+    }
+}
+
+static void finish_test(driver_env_t env, struct test_type *type, int slot, seL4_MessageInfo_t info, int result)
+{
+    run_entry_t *entry = slots[slot].entry;
+
+    /* save the fault before anything else uses the IPC buffer */
+    if (seL4_MessageInfo_get_label(info) != seL4_Fault_NullFault) {
+        entry->faulted = true;
+        entry->fault_info = info;
+        for (int i = 0; i < MIN(seL4_MessageInfo_get_length(info), seL4_MsgMaxLength); i++) {
+            entry->fault_mrs[i] = seL4_GetMR(i);
+        }
+    }
+
+    timing_end_phase(env, &entry->timing, PHASE_RUN);
+    entry->state = TEST_FINISHED;
+    entry->result = result;
+    env->test->failed = result != SUCCESS;
+    entry->usage = env->test->init->usage;
+    copy_output(env, entry);
+    if (entry->faulted) {
+        /* the process is kept until the test is reported, but whatever else
+         * the test was running must not carry on alongside other tests */
+        teardown_stop_test(env, slots[slot].pool, env->test);
+    }
+
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        watchdog_disarm(env);
+        timer_cleanup(env);
+        timer_reset(env);
+    }
+
+    if (flaky_attempt(env, entry->test, &entry->attempts, result)) {
+        /* run it again once there is a slot for it, only the output of the
+         * last attempt is kept, but how the attempt ended is printed now */
+        print_end(entry);
+        release_slot(env, type, slot);
+        free(entry->output);
+        entry->output = NULL;
+        entry->output_len = 0;
+        entry->truncated = false;
+        entry->faulted = false;
+        entry->timed_out = false;
+        entry->state = TEST_WAITING;
+        return;
+    }
+    if (entry->attempts.quarantined) {
+        entry->result = SUCCESS;
+    }
+
+    if (!entry->faulted && !entry->timed_out) {
+        release_slot(env, type, slot);
+    }
+}
+
+/* Serve the running tests until one of them sends something */
+static void serve_tests(driver_env_t env, struct test_type *type, sel4rpc_server_env_t *rpc_server)
+{
+    seL4_Word badge = 0;
+
+    driver_unlock(env);
+    seL4_MessageInfo_t info = api_recv(env->parallel_endpoint.cptr, &badge, env->reply.cptr);
+    driver_lock_after_recv(env, info);
+
+    if (!(badge & TEST_BADGE_BIT)) {
+        /* the interrupt is not for any one test */
+        env->test_service = NULL;
+        uint64_t start = service_start(env);
+        basic_handle_timer_irq(env, badge);
+        service_end(env, SERVICE_IRQ, start);
+        for (int slot = 0; slot < env->num_test_slots; slot++) {
+            if (slots[slot].entry != NULL && slots[slot].entry->state == TEST_RUNNING &&
+                watchdog_has_expired(env, slot)) {
+                select_slot(env, slot);
+                basic_time_out(env, env->test);
+                slots[slot].entry->timed_out = true;
+                finish_test(env, type, slot, seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 0), FAILURE);
+            }
+        }
+        env->test = NULL;
+        env->test_untypeds = NULL;
+        return;
+    }
+
+    int slot = TEST_BADGE_SLOT(badge);
+    assert(slot < env->num_test_slots && slots[slot].entry != NULL);
+    select_slot(env, slot);
+    env->test_service = &slots[slot].entry->service;
+
+    int result;
+    if (basic_handle_message(env, rpc_server, info, &result)) {
+        finish_test(env, type, slot, info, result);
+    }
+
+    env->test = NULL;
+    env->test_untypeds = NULL;
+    env->test_service = NULL;
+}
+
+/* Report a finished test. Returns SUCCESS, unless the test stops the run. */
+static test_result_t report_test(driver_env_t env, struct test_type *type, run_entry_t *entry,
+                                 int *tests_done, int *tests_failed)
+{
+    sel4test_start_test(entry->test->name, *tests_done);
+
+    if (entry->output != NULL) {
+        printf("%.*s", (int) entry->output_len, entry->output);
+        free(entry->output);
+        entry->output = NULL;
+    }
+    if (entry->truncated) {
+        printf("(output of %s truncated)\n", entry->test->name);
+    }
+
+    if (entry->faulted || entry->timed_out) {
+        print_end(entry);
+        release_slot(env, type, entry->slot);
+    }
+
+    env->timing = entry->timing;
+    env->attempts = entry->attempts;
+    env->usage = entry->usage;
+    env->have_usage = config_set(CONFIG_REPORT_RESOURCES);
+    env->service = entry->service;
+    sel4test_end_test(entry->result);
+
+    if (entry->result != SUCCESS) {
+        (*tests_failed)++;
+        if (run_config.halt_on_failure || entry->result == ABORT) {
+            return entry->result;
+        }
+    }
+    (*tests_done)++;
+    return SUCCESS;
+}
+
+test_result_t parallel_run_tests(driver_env_t env, struct test_type *type, testcase_t *tests[], int num_tests,
+                                 int *tests_done, int *tests_failed)
+{
+    run_entry_t *run = calloc(num_tests, sizeof(run_entry_t));
+    ZF_LOGF_IF(run == NULL, "Failed to allocate test run");
+
+    regex_t reg;
+    int error = regcomp(&reg, CONFIG_PARALLEL_EXCLUSIVE_REGEX, REG_EXTENDED | REG_NOSUB);
+    ZF_LOGF_IF(error, "Error compiling regex \"%s\"", CONFIG_PARALLEL_EXCLUSIVE_REGEX);
+
+    int num_run = 0;
+    for (int i = 0; i < num_tests; i++) {
+        if (tests[i]->test_type == type->id) {
+            run[num_run].test = tests[i];
+            run[num_run].exclusive = regexec(&reg, tests[i]->name, 0, NULL, 0) == 0;
+            num_run++;
+        }
+    }
+    regfree(&reg);
+    /* tests are started out of order from here on, scripts/relaunch.py
+     * cannot resume the run by test index */
+    printf("Running %d %s tests in parallel on %d cores\n", num_run, type->name, env->num_test_slots);
+
+    sel4rpc_server_env_t rpc_server;
+    sel4rpc_server_init(&rpc_server, &env->vka, refill_rpc_handler, env,
+                        &env->reply, &env->simple);
+
+    env->in_parallel = true;
+    test_result_t result = SUCCESS;
+    int next = 0;
+    int report = 0;
+    while (report < num_run) {
+        /* start tests that failed an attempt again */
+        for (int i = report; i < next; i++) {
+            if (run[i].state == TEST_WAITING) {
+                int slot = find_slot(env, &run[i]);
+                if (slot >= 0) {
+                    start_test(env, type, &run[i], slot);
+                }
+            }
+        }
+
+        /* start tests in order while there are slots for them */
+        while (next < num_run && next < report + MAX_TESTS_AHEAD) {
+            int slot = find_slot(env, &run[next]);
+            if (slot < 0) {
+                break;
+            }
+            start_test(env, type, &run[next], slot);
+            next++;
+        }
+
+        if (run[report].state != TEST_FINISHED) {
+            serve_tests(env, type, &rpc_server);
+            continue;
+        }
+
+        result = report_test(env, type, &run[report], tests_done, tests_failed);
+        if (result != SUCCESS) {
+            break;
+        }
+        report++;
+    }
+
+    /* the run was stopped, stop the tests that are still running */
+    for (int i = 0; i < env->num_test_slots; i++) {
+        if (slots[i].entry != NULL) {
+            error = seL4_TCB_Suspend(slots[i].process->process.thread.tcb.cptr);
+            ZF_LOGF_IF(error, "Failed to suspend test process");
+        }
+    }
+    for (int i = 0; i < num_run; i++) {
+        free(run[i].output);
+    }
+    env->in_parallel = false;
+    env->timer_slot = 0;
+    free(run);
+
+    return result;
+}
+
+#endif /* CONFIG_PARALLEL_TESTS */
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <sel4test/test.h>
+
+#include "test.h"
+
+/* Running BASIC tests in parallel (CONFIG_PARALLEL_TESTS). Each core is a test
+ * slot that runs one test process at a time, pinned to that core and using
+ * the untyped pool of the slot. All test processes report to one endpoint,
+ * badged with their slot, so the driver serves them all from one loop.
+ *
+ * Tests are started in order, and reported strictly in order once finished,
+ * with the output each test buffered. This keeps the output the same as when
+ * running the tests one at a time, apart from the order in which diagnostics
+ * of the driver appear. Tests matching CONFIG_PARALLEL_EXCLUSIVE_REGEX run
+ * alone. */
+
+/* Set up the endpoint and notifications of the test slots. */
+void parallel_init(driver_env_t env);
+
+/* Give a test process that has been set up for a test slot the caps of the
+ * slot, and pin it to the core of the slot. */
+void parallel_join_slot(driver_env_t env, test_process_t *test, int slot);
+
+/* Run and report the tests of a test type. Returns SUCCESS once all tests
+ * have been reported, or the result of the test that stops the run. */
+test_result_t parallel_run_tests(driver_env_t env, struct test_type *type, testcase_t *tests[], int num_tests,
+                                 int *tests_done, int *tests_failed);
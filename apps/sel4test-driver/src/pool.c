@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <vspace/vspace.h>
+#include <utils/util.h>
+
+#include "pool.h"
+#include "worker.h"
+
+typedef enum {
+    /* no process, free to be filled */
+    POOL_EMPTY,
+    /* process spawned and waiting for a test */
+    POOL_READY,
+    /* process handed out to a test */
+    POOL_ACTIVE,
+} pool_state_t;
+
+typedef struct pool_entry {
+    test_process_t test;
+    pool_state_t state;
+} pool_entry_t;
+
+/* one for each running test plus the ones waiting behind them */
+#define POOL_SIZE (CONFIG_PROCESS_POOL_DEPTH + MAX_TEST_SLOTS)
+
+static pool_entry_t pool[POOL_SIZE];
+static bool pool_initialised;
+static bool pool_filling;
+
+static pool_entry_t *find_entry(pool_state_t state)
+{
+    for (int i = 0; i < POOL_SIZE; i++) {
+        if (pool[i].state == state) {
+            return &pool[i];
+        }
+    }
+    return NULL;
+}
+
+static void pool_build(driver_env_t env, pool_entry_t *entry)
+{
+    /* start from the data that is the same for all tests */
+    memcpy(entry->test.init, env->init, sizeof(test_init_data_t));
+    basic_configure_process(env, &entry->test);
+    entry->state = POOL_READY;
+}
+
+/* worker job: build one process if there is room for it */
+static bool pool_refill(driver_env_t env)
+{
+    driver_lock(env);
+    pool_entry_t *entry = pool_filling ? find_entry(POOL_EMPTY) : NULL;
+    if (entry != NULL) {
+        pool_build(env, entry);
+    }
+    driver_unlock(env);
+
+    return entry != NULL;
+}
+
+void pool_start(driver_env_t env)
+{
+    if (!pool_initialised) {
+        for (int i = 0; i < POOL_SIZE; i++) {
+            pool[i].test.init = vspace_new_pages(&env->vspace, seL4_AllRights, TEST_INIT_DATA_PAGES,
+                                                 PAGE_BITS_4K);
+            ZF_LOGF_IF(pool[i].test.init == NULL, "Failed to allocate init data frame for process pool");
+            pool[i].state = POOL_EMPTY;
+        }
+        worker_add_job(pool_refill);
+        worker_init(env);
+        pool_initialised = true;
+    }
+
+    pool_filling = true;
+    worker_wake(env);
+}
+
+test_process_t *pool_take(driver_env_t env)
+{
+    pool_entry_t *entry = find_entry(POOL_READY);
+    if (entry == NULL) {
+        /* the worker has not kept up, build one ourselves */
+        entry = find_entry(POOL_EMPTY);
+        assert(entry != NULL);
+        pool_build(env, entry);
+    }
+    entry->state = POOL_ACTIVE;
+
+    /* the process can now be replaced while the test runs */
+    worker_wake(env);
+    return &entry->test;
+}
+
+void pool_release(driver_env_t env, test_process_t *test)
+{
+    for (int i = 0; i < POOL_SIZE; i++) {
+        if (&pool[i].test == test) {
+            assert(pool[i].state == POOL_ACTIVE);
+            pool[i].state = POOL_EMPTY;
+        }
+    }
+    worker_wake(env);
+}
+
+void pool_stop(driver_env_t env)
+{
+    pool_filling = false;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        if (pool[i].state == POOL_READY) {
+            basic_destroy_process(env, &pool[i].test);
+            pool[i].state = POOL_EMPTY;
+        }
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include "test.h"
+
+/* Pool of test processes that are created ahead of the tests that will run
+ * in them (CONFIG_PROCESS_POOL_DEPTH). The pool is refilled by the worker
+ * thread while the current test runs, so starting the next test only costs
+ * handing over its untypeds and resuming it. */
+
+/* Start filling the pool. */
+void pool_start(driver_env_t env);
+
+/* Take a process from the pool, creating one if the pool is empty. The
+ * process has been spawned but not resumed. */
+test_process_t *pool_take(driver_env_t env);
+
+/* Return the slot of a process that has been destroyed to the pool. */
+void pool_release(driver_env_t env, test_process_t *test);
+
+/* Stop filling the pool and destroy any processes still in it. */
+void pool_stop(driver_env_t env);
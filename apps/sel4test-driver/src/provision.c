@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <assert.h>
+
+#include <vka/capops.h>
+#include <vka/object.h>
+#include <utils/util.h>
+
+#include "provision.h"
+
+/* the root cnode of a test process has one slot for its own cnode and one
+ * for the provisioning cnode */
+#define ROOT_CNODE_BITS 1
+#define ROOT_OWN_SLOT 0
+#define ROOT_PROVISION_SLOT 1
+
+/* cspace depth of a test process, including the root cnode */
+#define TEST_CSPACE_DEPTH (TEST_PROCESS_CSPACE_SIZE_BITS + ROOT_CNODE_BITS)
+
+/* cptr, in a test process, of a slot in its provisioning cnode */
+#define PROVISION_CPTR(slot) (BIT(TEST_PROCESS_CSPACE_SIZE_BITS) | (slot))
+
+/* caps other than untypeds held by every provisioning cnode */
+#define MAX_STATIC_CAPS (5 + CONFIG_MAX_NUM_NODES)
+
+static cspacepath_t provision_path(untyped_pool_t *pool, seL4_Word slot)
+{
+    return (cspacepath_t) {
+        .root = pool->cnode.cptr,
+        .capPtr = slot,
+        .capDepth = pool->cnode.size_bits,
+    };
+}
+
+/* copy a cap of the driver into a provisioning cnode, returning its cptr in
+ * a test process */
+static seL4_CPtr provision_copy(driver_env_t env, untyped_pool_t *pool, seL4_Word *slot, seL4_CPtr cap)
+{
+    cspacepath_t src, dest = provision_path(pool, *slot);
+    vka_cspace_make_path(&env->vka, cap, &src);
+    int error = vka_cnode_copy(&dest, &src, seL4_AllRights);
+    ZF_LOGF_IF(error, "Failed to copy cap into provisioning cnode");
+
+    return PROVISION_CPTR((*slot)++);
+}
+
+/* caps of the driver copied into every provisioning cnode ahead of the
+ * untypeds, by slot, so that they can be put back if a test takes them out */
+static seL4_CPtr static_caps[MAX_STATIC_CAPS];
+
+static seL4_CPtr provision_static(driver_env_t env, untyped_pool_t *pool, seL4_Word *slot, seL4_CPtr cap)
+{
+    assert(*slot < MAX_STATIC_CAPS);
+    static_caps[*slot] = cap;
+    return provision_copy(env, pool, slot, cap);
+}
+
+/* Put a cap back into a provisioning cnode if a test deleted it or moved it
+ * out. Copying into a slot that is not empty fails with seL4_DeleteFirst, so
+ * a cap that is still there costs one syscall. */
+static void provision_restore(driver_env_t env, untyped_pool_t *pool, seL4_Word slot, seL4_CPtr cap)
+{
+    cspacepath_t src, dest = provision_path(pool, slot);
+    vka_cspace_make_path(&env->vka, cap, &src);
+    int error = vka_cnode_copy(&dest, &src, seL4_AllRights);
+    if (error == seL4_RevokeFirst) {
+        /* an untyped can only be copied once nothing is derived from it, such
+         * as the copy the test moved out */
+        vka_cnode_revoke(&src);
+        error = vka_cnode_copy(&dest, &src, seL4_AllRights);
+    }
+    ZF_LOGF_IF(error != seL4_NoError && error != seL4_DeleteFirst, "Failed to restore provisioned cap");
+}
+
+static void provision_pool(driver_env_t env, untyped_pool_t *pool)
+{
+    size_t size_bits = 1;
+    while (BIT(size_bits) < MAX_STATIC_CAPS + pool->num_untypeds) {
+        size_bits++;
+    }
+    ZF_LOGF_IF(size_bits > TEST_PROCESS_CSPACE_SIZE_BITS, "Too many untypeds to provision");
+
+    int error = vka_alloc_cnode_object(&env->vka, size_bits, &pool->cnode);
+    ZF_LOGF_IF(error, "Failed to allocate provisioning cnode");
+
+    /* every provisioning cnode has the same layout, so the cptrs written to
+     * the init data hold for all of them */
+    seL4_Word slot = 0;
+    env->init->domain = provision_static(env, pool, &slot, simple_get_init_cap(&env->simple, seL4_CapDomain));
+    env->init->asid_pool = provision_static(env, pool, &slot, simple_get_init_cap(&env->simple,
+                                                                                   seL4_CapInitThreadASIDPool));
+    env->init->asid_ctrl = provision_static(env, pool, &slot, simple_get_init_cap(&env->simple, seL4_CapASIDControl));
+#ifdef CONFIG_IOMMU
+    env->init->io_space = provision_static(env, pool, &slot, simple_get_init_cap(&env->simple, seL4_CapIOSpace));
+#endif /* CONFIG_IOMMU */
+    env->init->cores = simple_get_core_count(&env->simple);
+    /* copy the sched ctrl caps, one for each core */
+    if (config_set(CONFIG_KERNEL_MCS)) {
+        env->init->sched_ctrl = provision_static(env, pool, &slot, simple_get_sched_ctrl(&env->simple, 0));
+        for (int i = 1; i < env->init->cores; i++) {
+            provision_static(env, pool, &slot, simple_get_sched_ctrl(&env->simple, i));
+        }
+    }
+#ifdef CONFIG_ALLOW_SMC_CALLS
+    env->init->smc = provision_static(env, pool, &slot, simple_get_init_cap(&env->simple, seL4_CapSMC));
+#endif /* CONFIG_ALLOW_SMC_CALLS */
+    assert(slot <= MAX_STATIC_CAPS);
+
+    pool->first_untyped = slot;
+    for (int i = 0; i < pool->num_untypeds; i++) {
+        provision_copy(env, pool, &slot, pool->untypeds[i].cptr);
+    }
+}
+
+void provision_init(driver_env_t env)
+{
+    for (int i = 0; i < env->num_untyped_pools; i++) {
+        provision_pool(env, &env->untyped_pools[i]);
+    }
+}
+
+void provision_install(driver_env_t env, test_process_t *test)
+{
+    int error = vka_alloc_cnode_object(&env->vka, ROOT_CNODE_BITS, &test->root);
+    ZF_LOGF_IF(error, "Failed to allocate root cnode for test process");
+
+    /* the cnode of the process goes in without a guard, so that cptrs below
+     * BIT(TEST_PROCESS_CSPACE_SIZE_BITS) resolve exactly as they did before */
+    cspacepath_t own, dest = {
+        .root = test->root.cptr,
+        .capPtr = ROOT_OWN_SLOT,
+        .capDepth = ROOT_CNODE_BITS,
+    };
+    vka_cspace_make_path(&env->vka, test->process.cspace.cptr, &own);
+    error = vka_cnode_mint(&dest, &own, seL4_AllRights, api_make_guard_skip_word(0));
+    ZF_LOGF_IF(error, "Failed to add cnode of test process to its root cnode");
+
+    /* let the process address its whole cspace through the root */
+    seL4_Word root_data = api_make_guard_skip_word(seL4_WordBits - TEST_CSPACE_DEPTH);
+    cspacepath_t root;
+    vka_cspace_make_path(&env->vka, test->root.cptr, &root);
+    test->root_slot = sel4utils_mint_cap_to_process(&test->process, root, seL4_AllRights, root_data);
+    test->init->root_cnode = test->root_slot;
+    test->init->cspace_size_bits = TEST_CSPACE_DEPTH;
+
+    provision_set_space(env, test);
+}
+
+void provision_set_space(driver_env_t env, test_process_t *test)
+{
+#ifdef CONFIG_KERNEL_MCS
+    seL4_CPtr fault_ep = test->process.fault_endpoint.cptr;
+#else
+    seL4_CPtr fault_ep = SEL4UTILS_ENDPOINT_SLOT;
+#endif
+    seL4_Word root_data = api_make_guard_skip_word(seL4_WordBits - TEST_CSPACE_DEPTH);
+    int error = seL4_TCB_SetSpace(test->process.thread.tcb.cptr, fault_ep, test->root.cptr, root_data,
+                                  test->process.pd.cptr, seL4_NilData);
+    ZF_LOGF_IF(error, "Failed to set cspace root of test process");
+}
+
+void provision_attach(driver_env_t env, test_process_t *test, untyped_pool_t *pool)
+{
+    cspacepath_t src, dest = {
+        .root = test->root.cptr,
+        .capPtr = ROOT_PROVISION_SLOT,
+        .capDepth = ROOT_CNODE_BITS,
+    };
+    vka_cspace_make_path(&env->vka, pool->cnode.cptr, &src);
+    seL4_Word guard = api_make_guard_skip_word(TEST_PROCESS_CSPACE_SIZE_BITS - pool->cnode.size_bits);
+    int error = vka_cnode_mint(&dest, &src, seL4_AllRights, guard);
+    ZF_LOGF_IF(error, "Failed to attach provisioning cnode to test process");
+
+    test->init->untypeds.start = PROVISION_CPTR(pool->first_untyped);
+    test->init->untypeds.end = PROVISION_CPTR(pool->first_untyped + pool->num_untypeds - 1);
+}
+
+void provision_revoke(driver_env_t env, untyped_pool_t *pool)
+{
+    for (int i = 0; i < pool->num_untypeds; i++) {
+        if (pool->dirty[i / seL4_WordBits] & BIT(i % seL4_WordBits)) {
+            cspacepath_t path = provision_path(pool, pool->first_untyped + i);
+            vka_cnode_revoke(&path);
+            provision_restore(env, pool, pool->first_untyped + i, pool->untypeds[i].cptr);
+        }
+    }
+    for (seL4_Word slot = 0; slot < pool->first_untyped; slot++) {
+        provision_restore(env, pool, slot, static_caps[slot]);
+    }
+}
+
+void provision_remove(driver_env_t env, test_process_t *test)
+{
+    /* the root cnode and the cnode of the process hold caps to each other,
+     * break the cycle so that both go away when they are freed */
+    cspacepath_t own = {
+        .root = test->root.cptr,
+        .capPtr = ROOT_OWN_SLOT,
+        .capDepth = ROOT_CNODE_BITS,
+    };
+    cspacepath_t root = {
+        .root = test->process.cspace.cptr,
+        .capPtr = test->root_slot,
+        .capDepth = TEST_PROCESS_CSPACE_SIZE_BITS,
+    };
+    vka_cnode_delete(&own);
+    vka_cnode_delete(&root);
+    vka_free_object(&env->vka, &test->root);
+}
+
+int provision_probe(driver_env_t env, untyped_pool_t *pool, seL4_Word *free_bytes)
+{
+    cspacepath_t scratch;
+    int error = vka_cspace_alloc_path(&env->vka, &scratch);
+    ZF_LOGF_IF(error, "Failed to allocate slot to probe provisioning cnode");
+
+    int caps = 0;
+    for (seL4_Word slot = 0; slot < BIT(pool->cnode.size_bits); slot++) {
+        /* copying fails with seL4_FailedLookup from an empty slot, and with
+         * seL4_RevokeFirst from an untyped that has children */
+        cspacepath_t path = provision_path(pool, slot);
+        error = vka_cnode_copy(&scratch, &path, seL4_AllRights);
+        if (error == seL4_FailedLookup) {
+            continue;
+        }
+        caps++;
+        if (error == seL4_NoError) {
+            vka_cnode_delete(&scratch);
+            if (slot >= pool->first_untyped && slot < pool->first_untyped + pool->num_untypeds) {
+                *free_bytes += BIT(pool->untypeds[slot - pool->first_untyped].size_bits);
+            }
+        }
+    }
+
+    vka_cspace_free_path(&env->vka, scratch);
+    return caps;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include "test.h"
+
+/* Caps that every BASIC test gets, such as its untypeds and the ASID control
+ * cap, are copied once into a provisioning cnode for each untyped pool.
+ *
+ * A test process gets a two slot root cnode: slot 0 holds the cnode created
+ * for the process by sel4utils, so existing cptrs are unchanged, and slot 1
+ * holds the provisioning cnode of its untyped pool. Handing a test its caps
+ * is then a single mint, however many untypeds there are.
+ *
+ * Tests share the provisioning cnode, and a CNode cap carries no rights that
+ * would stop a test from deleting or moving the caps in it. The caps a test
+ * took out are put back when its untypeds are revoked. */
+
+/* Build the provisioning cnodes and record where the caps they hold are found
+ * in the init data. */
+void provision_init(driver_env_t env);
+
+/* Give a new test process its root cnode. */
+void provision_install(driver_env_t env, test_process_t *test);
+
+/* Set the fault endpoint, cspace root and vspace root of a test process back
+ * to the ones it was given by provision_install. */
+void provision_set_space(driver_env_t env, test_process_t *test);
+
+/* Attach the provisioning cnode of an untyped pool to a test process. */
+void provision_attach(driver_env_t env, test_process_t *test, untyped_pool_t *pool);
+
+/* Delete everything a test made from the untypeds of a pool, and put back any
+ * cap the test deleted from or moved out of its provisioning cnode. Only the
+ * untypeds marked dirty are revoked and put back. */
+void provision_revoke(driver_env_t env, untyped_pool_t *pool);
+
+/* Look for what tests left behind in the provisioning cnode of a pool, once
+ * the pool has been reclaimed. Adds the bytes of the untypeds that nothing is
+ * retyped from to *free_bytes, and returns the number of caps in the cnode.
+ * Nothing is retyped to find out, so no memory is cleared. */
+int provision_probe(driver_env_t env, untyped_pool_t *pool, seL4_Word *free_bytes);
+
+/* Free the root cnode of a test process. Must be called before the process
+ * is destroyed. */
+void provision_remove(driver_env_t env, test_process_t *test);
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <sel4rpc/server.h>
+#include <utils/util.h>
+
+#include "refill.h"
+
+static bool handed_out(test_init_data_t *init, int i)
+{
+    return init->untypeds_used[i / seL4_WordBits] & BIT(i % seL4_WordBits);
+}
+
+/* Hand out the smallest untyped of the pool that is at least size_bits, and
+ * return its cookie, or UNTYPED_COOKIE_NONE if there is none */
+static seL4_Word hand_out(untyped_pool_t *pool, test_init_data_t *init, seL4_Word size_bits)
+{
+    for (seL4_Word bits = size_bits; bits < seL4_WordBits; bits++) {
+        int first = pool->first_of_size[bits];
+        for (int i = first; i < first + pool->num_of_size[bits]; i++) {
+            if (!handed_out(init, i)) {
+                /* marked before the test can retype anything from it */
+                init->untypeds_used[i / seL4_WordBits] |= BIT(i % seL4_WordBits);
+                return UNTYPED_COOKIE(i, bits);
+            }
+        }
+    }
+    return UNTYPED_COOKIE_NONE;
+}
+
+void refill_seed(driver_env_t env, untyped_pool_t *pool)
+{
+    test_init_data_t *init = env->test->init;
+
+    /* the largest untyped is the first */
+    seL4_Word max_size_bits = pool->untypeds[0].size_bits;
+    init->usage.untyped_bytes = pool->bytes;
+    init->untyped_seed = hand_out(pool, init, MIN((seL4_Word) CONFIG_UNTYPED_SEED_BITS, max_size_bits));
+}
+
+int refill_rpc_handler(sel4rpc_server_env_t *rpc_env, void *data, RpcMessage *msg)
+{
+    driver_env_t env = data;
+
+    if (msg->which_msg != RpcMessage_memory_tag || msg->msg.memory.address != UNTYPED_REFILL_ADDRESS) {
+        return sel4rpc_default_handler(rpc_env, data, msg);
+    }
+
+    /* the sender is the current test */
+    ZF_LOGF_IF(env->test == NULL || env->test_untypeds == NULL, "Untyped refill from no test");
+    test_init_data_t *init = env->test->init;
+    seL4_Word cookie = hand_out(env->test_untypeds, init, msg->msg.memory.size_bits);
+    init->usage.untyped_refills++;
+    return sel4rpc_server_reply(rpc_env, seL4_CapNull, cookie == UNTYPED_COOKIE_NONE ? -1 : 0, cookie);
+}
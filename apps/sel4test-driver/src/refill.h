@@ -0,0 +1,24 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <sel4rpc/server.h>
+
+#include "test.h"
+
+/* Untypeds are handed to a test process as it needs them, rather than all at
+ * once. The test starts with a seed untyped of about CONFIG_UNTYPED_SEED_BITS,
+ * and asks for more over sel4rpc when its allocator runs dry (see
+ * UNTYPED_REFILL_ADDRESS). Only the untypeds handed out have to be revoked
+ * after the test. */
+
+/* Hand the current test its seed untyped, from an untyped pool none of which
+ * has been handed out yet. */
+void refill_seed(driver_env_t env, untyped_pool_t *pool);
+
+/* sel4rpc handler of the driver. Serves untyped refills for the current test,
+ * and passes everything else on to sel4rpc_default_handler. */
+int refill_rpc_handler(sel4rpc_server_env_t *rpc_env, void *data, RpcMessage *msg);
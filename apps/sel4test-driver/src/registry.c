@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "registry.h"
+#include "test_registry.h"
+
+/* FNV-1a, with the seed mixed into the basis. Must match the generator. */
+static uint32_t registry_hash(const char *name, uint32_t seed)
+{
+    uint32_t hash = 0x811c9dc5 ^ seed;
+    for (const char *c = name; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t) *c) * 0x01000193;
+    }
+    return hash;
+}
+
+int test_registry_size(void)
+{
+    return TEST_REGISTRY_SIZE;
+}
+
+int test_registry_lookup(const char *name)
+{
+    uint32_t seed = test_registry_seeds[registry_hash(name, 0) % TEST_REGISTRY_BUCKETS];
+    int index = test_registry_slots[registry_hash(name, seed) % TEST_REGISTRY_SLOTS];
+
+    /* names that are not in the registry land on any slot */
+    if (index < 0 || strcmp(test_registry_names[index], name) != 0) {
+        return -1;
+    }
+    return index;
+}
+
+int test_registry_costs_known(void)
+{
+    return TEST_REGISTRY_COSTS_KNOWN;
+}
+
+uint32_t test_registry_cost(int index)
+{
+    return test_registry_cost_us[index];
+}
+
+bool test_registry_failed_before(int index)
+{
+    return test_registry_failed[index];
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sel4test/test.h>
+
+/* The tests to run are chosen at build time: tools/gen_test_registry.py finds
+ * the tests in the sources of both images, keeps the ones that match
+ * CONFIG_TESTPRINTER_REGEX, and sorts them into the order they run in. */
+
+/* Number of tests in the registry. Tests that are compiled out of both
+ * images have an entry but are never found. */
+int test_registry_size(void);
+
+/* Position of a test in the registry, or -1 if the test was not selected. */
+int test_registry_lookup(const char *name);
+
+/* Number of tests in the registry that the build time cost table has a time
+ * for. The others cost the mean of those, so the order does not depend on
+ * which tests are missing. */
+int test_registry_costs_known(void);
+
+/* Time the test at a position in the registry took in earlier runs, in us */
+uint32_t test_registry_cost(int index);
+
+/* Whether the test at a position in the registry failed in earlier runs */
+bool test_registry_failed_before(int index);
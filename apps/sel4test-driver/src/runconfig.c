@@ -0,0 +1,194 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cpio/cpio.h>
+#include <utils/util.h>
+#include <vka/object.h>
+#include <vspace/vspace.h>
+
+#include "runconfig.h"
+
+run_config_t run_config = {
+    .regex = NULL,
+    .shard_index = CONFIG_SHARD_INDEX,
+    .shard_count = CONFIG_SHARD_COUNT,
+    .start_index = CONFIG_START_INDEX,
+    .end_index = CONFIG_END_INDEX,
+    .repeat = 1,
+    .retries = CONFIG_TEST_RETRIES,
+    .quarantine = config_set(CONFIG_QUARANTINE_FLAKY),
+    .iterations = CONFIG_SOAK_ITERATIONS,
+    .soak_time_s = CONFIG_SOAK_TIME_LIMIT_S,
+    .print_xml = config_set(CONFIG_PRINT_XML),
+    .halt_on_failure = config_set(CONFIG_TESTPRINTER_HALT_ON_TEST_FAILURE),
+};
+
+static const char *order_names[] = {
+    [TEST_ORDER_DEFAULT] = "default",
+    [TEST_ORDER_LONGEST] = "longest",
+    [TEST_ORDER_FAILED] = "failed",
+};
+
+/* copy of the blob, that the parsed configuration points into */
+static char run_config_text[PAGE_SIZE_4K + 1];
+
+static int parse_int(const char *key, const char *value)
+{
+    char *end;
+    long n = strtol(value, &end, 0);
+    ZF_LOGF_IF(end == value || *end != '\0' || n < 0 || n > INT_MAX,
+               "Run config: invalid value \"%s\" for %s", value, key);
+    return n;
+}
+
+static test_order_t parse_order(const char *value)
+{
+    for (unsigned int i = 0; i < ARRAY_SIZE(order_names); i++) {
+        if (strcmp(value, order_names[i]) == 0) {
+            return i;
+        }
+    }
+    ZF_LOGF("Run config: unknown order \"%s\"", value);
+    return TEST_ORDER_DEFAULT;
+}
+
+const char *run_config_order_name(test_order_t order)
+{
+    return order_names[order];
+}
+
+static void parse_line(char *line)
+{
+    char *value = strchr(line, '=');
+    ZF_LOGF_IF(value == NULL, "Run config: expected key=value, got \"%s\"", line);
+    *value = '\0';
+    value++;
+
+    if (strcmp(line, "regex") == 0) {
+        run_config.regex = value;
+    } else if (strcmp(line, "shard") == 0) {
+        char *count = strchr(value, '/');
+        ZF_LOGF_IF(count == NULL, "Run config: expected shard=index/count, got \"%s\"", value);
+        *count = '\0';
+        run_config.shard_index = parse_int("shard index", value);
+        run_config.shard_count = parse_int("shard count", count + 1);
+    } else if (strcmp(line, "start") == 0) {
+        run_config.start_index = parse_int(line, value);
+    } else if (strcmp(line, "end") == 0) {
+        run_config.end_index = parse_int(line, value);
+    } else if (strcmp(line, "repeat") == 0) {
+        run_config.repeat = parse_int(line, value);
+        ZF_LOGF_IF(run_config.repeat == 0, "Run config: repeat must be at least 1");
+    } else if (strcmp(line, "order") == 0) {
+        run_config.order = parse_order(value);
+    } else if (strcmp(line, "retries") == 0) {
+        run_config.retries = parse_int(line, value);
+    } else if (strcmp(line, "quarantine") == 0) {
+        run_config.quarantine = parse_int(line, value) != 0;
+    } else if (strcmp(line, "iterations") == 0) {
+        run_config.iterations = parse_int(line, value);
+    } else if (strcmp(line, "soak_time") == 0) {
+        run_config.soak_time_s = parse_int(line, value);
+    } else if (strcmp(line, "format") == 0) {
+        if (strcmp(value, "xml") == 0) {
+            run_config.print_xml = true;
+        } else if (strcmp(value, "text") == 0) {
+            run_config.print_xml = false;
+        } else {
+            ZF_LOGF("Run config: unknown format \"%s\"", value);
+        }
+    } else if (strcmp(line, "halt_on_failure") == 0) {
+        run_config.halt_on_failure = parse_int(line, value) != 0;
+    } else {
+        ZF_LOGF("Run config: unknown key \"%s\"", line);
+    }
+}
+
+/* Parse a blob, returns false if it is not a run configuration */
+static bool parse(const char *blob, size_t len)
+{
+    len = MIN(len, sizeof(run_config_text) - 1);
+    memcpy(run_config_text, blob, len);
+    run_config_text[len] = '\0';
+
+    char *next = run_config_text;
+    char *line = strsep(&next, "\n");
+    if (strcmp(line, RUN_CONFIG_MAGIC) != 0) {
+        return false;
+    }
+
+    while (next != NULL) {
+        line = strsep(&next, "\n");
+        /* tolerate files written on other hosts */
+        line[strcspn(line, "\r")] = '\0';
+        if (line[0] != '\0' && line[0] != '#') {
+            parse_line(line);
+        }
+    }
+    return true;
+}
+
+/* Parse the blob in a page of physical memory */
+static bool load_from_paddr(driver_env_t env, uintptr_t paddr)
+{
+    ZF_LOGF_IF(!IS_ALIGNED(paddr, PAGE_BITS_4K), "Run config address %p is not page aligned", (void *) paddr);
+
+    vka_object_t frame;
+    int error = vka_alloc_frame_at(&env->vka, PAGE_BITS_4K, paddr, &frame);
+    if (error) {
+        ZF_LOGE("Failed to allocate the frame of the run config at %p", (void *) paddr);
+        return false;
+    }
+    void *blob = vspace_map_pages(&env->vspace, &frame.cptr, NULL, seL4_AllRights, 1, PAGE_BITS_4K, 1);
+    ZF_LOGF_IF(blob == NULL, "Failed to map the run config");
+
+    bool found = parse(blob, PAGE_SIZE_4K);
+
+    vspace_unmap_pages(&env->vspace, blob, 1, PAGE_BITS_4K, NULL);
+    vka_free_object(&env->vka, &frame);
+    return found;
+}
+
+void run_config_init(driver_env_t env, const void *archive, unsigned long archive_len)
+{
+    const char *source = NULL;
+
+    run_config.order = parse_order(CONFIG_TEST_ORDER);
+    if (CONFIG_RUN_CONFIG_PADDR != 0 && load_from_paddr(env, CONFIG_RUN_CONFIG_PADDR)) {
+        source = "memory";
+    } else {
+        unsigned long len;
+        const void *blob = cpio_get_file(archive, archive_len, RUN_CONFIG_FILE, &len);
+        if (blob != NULL) {
+            ZF_LOGF_IF(!parse(blob, len), RUN_CONFIG_FILE " does not start with " RUN_CONFIG_MAGIC);
+            source = RUN_CONFIG_FILE;
+        }
+    }
+
+    ZF_LOGF_IF(run_config.shard_count < 1 || run_config.shard_index >= run_config.shard_count,
+               "Shard %d of %d does not exist", run_config.shard_index, run_config.shard_count);
+    ZF_LOGF_IF(run_config.end_index != 0 && run_config.start_index > run_config.end_index,
+               "Tests %d to %d is not a range", run_config.start_index, run_config.end_index);
+
+    if (source != NULL) {
+        printf("Run config from %s: regex \"%s\", shard %d/%d, tests %d to %d, repeat %d, order %s, retries %d, "
+               "quarantine %d, iterations %d, soak time %d s, format %s, halt on failure %d\n", source,
+               run_config.regex ? run_config.regex : "", run_config.shard_index, run_config.shard_count,
+               run_config.start_index, run_config.end_index, run_config.repeat,
+               run_config_order_name(run_config.order), run_config.retries, run_config.quarantine,
+               run_config.iterations, run_config.soak_time_s, run_config.print_xml ? "xml" : "text",
+               run_config.halt_on_failure);
+    }
+}
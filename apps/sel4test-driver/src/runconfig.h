@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "test.h"
+
+/* The run configuration selects which tests run and how the results are
+ * printed, so that one image can be reused for different runs. It defaults
+ * to the build configuration, and can be overridden at boot by a blob taken
+ * from the RUN_CONFIG_FILE in the CPIO archive, or from the page at
+ * CONFIG_RUN_CONFIG_PADDR (for example filled by QEMU's -device loader).
+ *
+ * The blob is text, starting with a line holding RUN_CONFIG_MAGIC, followed
+ * by key=value lines. Blank lines and lines starting with '#' are ignored:
+ *
+ *   sel4test-run-config
+ *   regex=^(CNODEOP|RETYPE)
+ *   shard=0/4
+ *   start=12
+ *   end=40
+ *   repeat=2
+ *   order=longest
+ *   retries=3
+ *   quarantine=1
+ *   iterations=0
+ *   soak_time=3600
+ *   format=xml
+ *   halt_on_failure=1
+ *
+ * The regex can only select among the tests in the build time registry, so
+ * images that are meant to be reused should be built with the default
+ * CONFIG_TESTPRINTER_REGEX. */
+
+#define RUN_CONFIG_FILE "sel4test-run.conf"
+#define RUN_CONFIG_MAGIC "sel4test-run-config"
+
+/* Order to run the selected tests in, within each test type */
+typedef enum {
+    /* by name */
+    TEST_ORDER_DEFAULT,
+    /* longest first, by the cost table of the registry */
+    TEST_ORDER_LONGEST,
+    /* the tests that failed before first, then by name */
+    TEST_ORDER_FAILED,
+} test_order_t;
+
+typedef struct run_config {
+    /* POSIX regex that tests must also match to run, NULL for all */
+    const char *regex;
+    /* run every shard_count'th test, starting with test shard_index */
+    int shard_index;
+    int shard_count;
+    /* run the tests of the shard from start_index up to before end_index, in
+     * the order they run, or up to the last one if end_index is 0 */
+    int start_index;
+    int end_index;
+    /* times to run the selected tests */
+    int repeat;
+    /* order to run the selected tests in, before they are sharded */
+    test_order_t order;
+    /* times to run a test again when it fails */
+    int retries;
+    /* report flaky tests that fail every attempt without failing the run */
+    bool quarantine;
+    /* soak mode: times to run the whole selection, 0 to run until soak_time */
+    int iterations;
+    /* soak mode: seconds after which to stop starting iterations, 0 for no limit */
+    int soak_time_s;
+    /* print results as JUnit XML */
+    bool print_xml;
+    /* stop at the first test that fails */
+    bool halt_on_failure;
+} run_config_t;
+
+/* configuration of the current run */
+extern run_config_t run_config;
+
+/* Name of a test order, as in the run configuration */
+const char *run_config_order_name(test_order_t order);
+
+/* Load the run configuration blob, if there is one. */
+void run_config_init(driver_env_t env, const void *archive, unsigned long archive_len);
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <utils/util.h>
+
+#include "service.h"
+#include "test.h"
+#include "timer.h"
+
+typedef struct {
+    const char *name;
+    service_stats_t stats;
+} service_record_t;
+
+static const char *request_names[NUM_SERVICE_REQUESTS] = {
+    [SERVICE_IRQ] = "timer irq",
+    [SERVICE_TIMEOUT] = "timeout",
+    [SERVICE_TIMESTAMP] = "timestamp",
+    [SERVICE_TIMER_RESET] = "timer reset",
+    [SERVICE_RPC] = "rpc",
+    [SERVICE_PAGE_IN] = "page in",
+    [SERVICE_RESULT] = "result",
+};
+
+/* requests over the whole run */
+static service_stats_t run_stats;
+static uint64_t max_ns[NUM_SERVICE_REQUESTS];
+static uint64_t histogram[NUM_SERVICE_REQUESTS][SERVICE_HISTOGRAM_BUCKETS];
+
+static service_record_t *records;
+static int num_records;
+static int max_records;
+
+uint64_t service_start(driver_env_t env)
+{
+    return config_set(CONFIG_REPORT_SERVICE_TIME) ? timestamp(env) : 0;
+}
+
+void service_end(driver_env_t env, service_request_t request, uint64_t start)
+{
+    if (!config_set(CONFIG_REPORT_SERVICE_TIME)) {
+        return;
+    }
+    uint64_t ns = timestamp(env) - start;
+
+    if (env->test_service != NULL) {
+        env->test_service->count[request]++;
+        env->test_service->ns[request] += ns;
+    }
+    run_stats.count[request]++;
+    run_stats.ns[request] += ns;
+    max_ns[request] = MAX(max_ns[request], ns);
+
+    int bucket = 0;
+    for (uint64_t us = ns / NS_IN_US; us >= 2 && bucket < SERVICE_HISTOGRAM_BUCKETS - 1; us /= 2) {
+        bucket++;
+    }
+    histogram[request][bucket]++;
+}
+
+uint64_t service_total(service_stats_t *stats)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < NUM_SERVICE_REQUESTS; i++) {
+        total += stats->ns[i];
+    }
+    return total;
+}
+
+void service_init(int num_tests)
+{
+    if (!config_set(CONFIG_REPORT_SERVICE_TIME)) {
+        return;
+    }
+    records = calloc(num_tests, sizeof(service_record_t));
+    ZF_LOGF_IF(num_tests > 0 && records == NULL, "Failed to allocate test service times");
+    max_records = num_tests;
+    num_records = 0;
+}
+
+static void print_counts(service_stats_t *stats)
+{
+    const char *separator = "";
+    for (int i = 0; i < NUM_SERVICE_REQUESTS; i++) {
+        if (stats->count[i] > 0) {
+            printf("%s%s %llu", separator, request_names[i], (unsigned long long) stats->count[i]);
+            separator = ", ";
+        }
+    }
+}
+
+void service_record(const char *name, service_stats_t *stats, bool xml)
+{
+    if (!config_set(CONFIG_REPORT_SERVICE_TIME)) {
+        return;
+    }
+    if (!xml) {
+        printf("%s driver service %llu us (", name, (unsigned long long)(service_total(stats) / NS_IN_US));
+        print_counts(stats);
+        printf(")\n");
+    }
+    if (num_records == max_records) {
+        /* more tests can be recorded than were counted at boot */
+        int max = MAX(2 * max_records, 16);
+        service_record_t *more = realloc(records, max * sizeof(service_record_t));
+        ZF_LOGF_IF(more == NULL, "Failed to allocate test service times");
+        records = more;
+        max_records = max;
+    }
+    records[num_records].name = name;
+    records[num_records].stats = *stats;
+    num_records++;
+}
+
+static int most_service_first(const void *a, const void *b)
+{
+    uint64_t time_a = service_total(&((service_record_t *) a)->stats);
+    uint64_t time_b = service_total(&((service_record_t *) b)->stats);
+    return time_a < time_b ? 1 : time_a > time_b ? -1 : 0;
+}
+
+void service_print_summary(void)
+{
+    if (!config_set(CONFIG_REPORT_SERVICE_TIME)) {
+        return;
+    }
+
+    printf("Driver service time:\n");
+    for (int i = 0; i < NUM_SERVICE_REQUESTS; i++) {
+        if (run_stats.count[i] == 0) {
+            continue;
+        }
+        printf("  %-12s %8llu requests %8llu us, mean %llu ns, max %llu us:", request_names[i],
+               (unsigned long long) run_stats.count[i], (unsigned long long)(run_stats.ns[i] / NS_IN_US),
+               (unsigned long long)(run_stats.ns[i] / run_stats.count[i]),
+               (unsigned long long)(max_ns[i] / NS_IN_US));
+        for (int b = 0; b < SERVICE_HISTOGRAM_BUCKETS; b++) {
+            if (histogram[i][b] == 0) {
+                continue;
+            }
+            if (b == SERVICE_HISTOGRAM_BUCKETS - 1) {
+                printf(" >=%llu us %llu", 1ull << b, (unsigned long long) histogram[i][b]);
+            } else {
+                printf(" <%llu us %llu", 2ull << b, (unsigned long long) histogram[i][b]);
+            }
+        }
+        printf("\n");
+    }
+
+    if (num_records == 0) {
+        return;
+    }
+    qsort(records, num_records, sizeof(service_record_t), most_service_first);
+    printf("Tests with the most driver service time:\n");
+    for (int i = 0; i < MIN(num_records, NUM_SERVICE_TESTS); i++) {
+        printf("  %-24s %8llu us (", records[i].name,
+               (unsigned long long)(service_total(&records[i].stats) / NS_IN_US));
+        print_counts(&records[i].stats);
+        printf(")\n");
+    }
+
+    free(records);
+    records = NULL;
+    num_records = 0;
+    max_records = 0;
+}
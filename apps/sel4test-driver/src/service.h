@@ -0,0 +1,66 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Time the driver spends serving the requests of tests, for
+ * CONFIG_REPORT_SERVICE_TIME. Each request is timed from when the driver
+ * receives it until it is done with it, and counted for the test that made
+ * it and for the whole run. */
+
+/* Number of buckets of the latency histograms. Bucket 0 is under 2 us, and
+ * each bucket after it is twice as wide, the last one has the rest. */
+#define SERVICE_HISTOGRAM_BUCKETS 12
+
+/* Number of the tests that took the most service time to list at the end */
+#define NUM_SERVICE_TESTS 10
+
+typedef enum {
+    /* timer interrupts that woke the driver */
+    SERVICE_IRQ,
+    /* SEL4TEST_TIME_TIMEOUT, SEL4TEST_TIME_TIMESTAMP and SEL4TEST_TIME_RESET */
+    SERVICE_TIMEOUT,
+    SERVICE_TIMESTAMP,
+    SERVICE_TIMER_RESET,
+    /* SEL4TEST_PROTOBUF_RPC, such as untyped refills and caps */
+    SERVICE_RPC,
+    /* pages of the image paged in (CONFIG_DEMAND_PAGING) */
+    SERVICE_PAGE_IN,
+    /* the result or fault that ended the test */
+    SERVICE_RESULT,
+    NUM_SERVICE_REQUESTS,
+} service_request_t;
+
+/* Requests served for a test, and how long they took */
+typedef struct service_stats {
+    uint64_t count[NUM_SERVICE_REQUESTS];
+    uint64_t ns[NUM_SERVICE_REQUESTS];
+} service_stats_t;
+
+struct driver_env;
+
+/* Start timing a request, returns when it started */
+uint64_t service_start(struct driver_env *env);
+
+/* Count a request that started at start, for the current test if there is one
+ * (env->test_service) and for the run */
+void service_end(struct driver_env *env, service_request_t request, uint64_t start);
+
+/* Total time of the requests of a test */
+uint64_t service_total(service_stats_t *stats);
+
+/* Make room to keep the service times of num_tests tests, more room is made if
+ * more are recorded */
+void service_init(int num_tests);
+
+/* Print the requests of a test, and keep them for the summary */
+void service_record(const char *name, service_stats_t *stats, bool xml);
+
+/* Print the requests of each type over the run with their latency histograms,
+ * and the tests that took the most service time */
+void service_print_summary(void);
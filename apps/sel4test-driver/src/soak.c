@@ -0,0 +1,256 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/util.h>
+#include <vka/object.h>
+
+#include "provision.h"
+#include "runconfig.h"
+#include "soak.h"
+#include "teardown.h"
+#include "test.h"
+#include "timer.h"
+
+/* Sizes of untyped to probe the free memory of the driver with */
+#define PROBE_MAX_BITS 24
+#define PROBE_MAX_OBJECTS 256
+
+typedef struct {
+    const char *name;
+    uint64_t first;
+    uint64_t now;
+} soak_drift_t;
+
+/* what each test did in the first iteration */
+static const char **names;
+static uint64_t *first_ns;
+static uint64_t *first_retyped;
+static int max_tests;
+
+static int iteration;
+static bool in_iteration;
+/* position of the next test in the iteration */
+static int position;
+static uint64_t soak_start_ns;
+static uint64_t start_ns;
+static size_t first_free;
+static seL4_Word first_pool_free;
+static int first_pool_caps;
+
+/* the tests that drifted the most in this iteration, and how many did */
+static soak_drift_t slower[NUM_SOAK_DRIFTED_TESTS];
+static int num_slower;
+static soak_drift_t retyped[NUM_SOAK_DRIFTED_TESTS];
+static int num_retyped;
+
+static vka_object_t probe_objects[PROBE_MAX_OBJECTS];
+
+bool soak_enabled(void)
+{
+    return run_config.iterations != 1 || run_config.soak_time_s != 0;
+}
+
+/* Memory the driver can still allocate, found by allocating as much of it as
+ * possible and giving it all back. Memory of the driver allocator that tear
+ * down leaks, such as the objects of test processes, is gone from here. */
+static size_t probe_free_memory(driver_env_t env)
+{
+    size_t free_bytes = 0;
+    int n = 0;
+
+    for (int bits = PROBE_MAX_BITS; bits >= seL4_PageBits && n < PROBE_MAX_OBJECTS; bits--) {
+        while (n < PROBE_MAX_OBJECTS && vka_alloc_untyped(&env->vka, bits, &probe_objects[n]) == 0) {
+            free_bytes += BIT(bits);
+            n++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        vka_free_object(&env->vka, &probe_objects[i]);
+    }
+    return free_bytes;
+}
+
+/* Memory of the test untyped pools that nothing is retyped from, and the caps
+ * their provisioning cnodes hold. Objects that a test made and its tear down
+ * did not revoke, and caps a test left in a provisioning cnode, show up here
+ * from one iteration to the next. */
+static seL4_Word probe_test_pools(driver_env_t env, int *caps)
+{
+    seL4_Word free_bytes = 0;
+    *caps = 0;
+    for (int i = 0; i < env->num_untyped_pools; i++) {
+        teardown_wait(env, &env->untyped_pools[i]);
+        *caps += provision_probe(env, &env->untyped_pools[i], &free_bytes);
+    }
+    return free_bytes;
+}
+
+/* Print how a value changed since the first iteration */
+static void print_change(uint64_t first, uint64_t now, uint64_t scale, const char *unit)
+{
+    if (iteration > 0) {
+        printf(" (%s%llu%s since iteration 0)", now < first ? "-" : "+",
+               (unsigned long long)((now < first ? first - now : now - first) / scale), unit);
+    }
+}
+
+static uint64_t total_retyped(test_usage_t *usage)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < seL4_ObjectTypeCount; i++) {
+        total += usage->retyped_bytes[i];
+    }
+    return total;
+}
+
+/* Count a drifted test, keeping the ones that drifted the most */
+static void add_drift(soak_drift_t drifts[], int *num_drifts, const char *name, uint64_t first, uint64_t now)
+{
+    int keep = MIN(*num_drifts, NUM_SOAK_DRIFTED_TESTS);
+    (*num_drifts)++;
+
+    /* drift is compared as now / first, without dividing */
+    int i = keep;
+    while (i > 0 && now * drifts[i - 1].first > drifts[i - 1].now * first) {
+        if (i < NUM_SOAK_DRIFTED_TESTS) {
+            drifts[i] = drifts[i - 1];
+        }
+        i--;
+    }
+    if (i < NUM_SOAK_DRIFTED_TESTS) {
+        drifts[i] = (soak_drift_t) {
+            .name = name, .first = first, .now = now
+        };
+    }
+}
+
+static void print_drifts(soak_drift_t drifts[], int num_drifts, uint64_t scale, const char *unit)
+{
+    int shown = MIN(num_drifts, NUM_SOAK_DRIFTED_TESTS);
+    for (int i = 0; i < shown; i++) {
+        printf(" %s %llu -> %llu %s%s", drifts[i].name, (unsigned long long)(drifts[i].first / scale),
+               (unsigned long long)(drifts[i].now / scale), unit, i + 1 < shown ? "," : "");
+    }
+    printf(num_drifts > NUM_SOAK_DRIFTED_TESTS ? ", ...\n" : "\n");
+}
+
+void soak_init(int num_tests)
+{
+    if (!soak_enabled()) {
+        return;
+    }
+    ZF_LOGF_IF(run_config.iterations == 0 && (run_config.soak_time_s == 0 || !config_set(CONFIG_HAVE_TIMER)),
+               "Soak mode without a number of iterations needs a time limit and a timer");
+
+    names = calloc(num_tests, sizeof(*names));
+    first_ns = calloc(num_tests, sizeof(*first_ns));
+    first_retyped = calloc(num_tests, sizeof(*first_retyped));
+    ZF_LOGF_IF(num_tests > 0 && (names == NULL || first_ns == NULL || first_retyped == NULL),
+               "Failed to allocate soak records");
+    max_tests = num_tests;
+    iteration = 0;
+}
+
+void soak_start_iteration(driver_env_t env)
+{
+    if (!soak_enabled()) {
+        return;
+    }
+    printf("Soak iteration %d\n", iteration);
+    in_iteration = true;
+    position = 0;
+    num_slower = 0;
+    num_retyped = 0;
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        start_ns = timestamp(env);
+        if (iteration == 0) {
+            soak_start_ns = start_ns;
+        }
+    }
+}
+
+void soak_record(const char *name, test_timing_t *timing, test_usage_t *usage)
+{
+    if (!in_iteration || position >= max_tests) {
+        return;
+    }
+    int i = position++;
+    uint64_t now = timing_total(timing);
+    uint64_t now_retyped = usage != NULL ? total_retyped(usage) : 0;
+
+    if (iteration == 0) {
+        names[i] = name;
+        first_ns[i] = now;
+        first_retyped[i] = now_retyped;
+        return;
+    }
+
+    /* the same tests run in the same order every iteration */
+    ZF_LOGF_IF(names[i] != name, "Soak iteration %d ran %s where %s ran before", iteration, name, names[i]);
+    if (timing->timed && now > first_ns[i] + SOAK_DRIFT_MIN_NS &&
+        now * 100 > first_ns[i] * (100 + CONFIG_SOAK_DRIFT_PERCENT)) {
+        add_drift(slower, &num_slower, name, first_ns[i], now);
+    }
+    if (now_retyped > first_retyped[i]) {
+        add_drift(retyped, &num_retyped, name, first_retyped[i], now_retyped);
+    }
+}
+
+void soak_end_iteration(driver_env_t env)
+{
+    if (!soak_enabled()) {
+        return;
+    }
+    in_iteration = false;
+    size_t free_bytes = probe_free_memory(env);
+    int pool_caps;
+    seL4_Word pool_free = probe_test_pools(env, &pool_caps);
+    if (iteration == 0) {
+        first_free = free_bytes;
+        first_pool_free = pool_free;
+        first_pool_caps = pool_caps;
+    }
+
+    printf("Soak iteration %d done", iteration);
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        printf(" in %llu ms", (unsigned long long)((timestamp(env) - start_ns) / NS_IN_MS));
+    }
+    printf(", driver has %zu KiB free", free_bytes / 1024);
+    print_change(first_free, free_bytes, 1024, " KiB");
+    printf(", test pools %lu KiB free", (unsigned long)(pool_free / 1024));
+    print_change(first_pool_free, pool_free, 1024, " KiB");
+    printf(", provisioning cnodes hold %d caps", pool_caps);
+    print_change(first_pool_caps, pool_caps, 1, "");
+    printf("\n");
+    if (num_slower > 0) {
+        printf("  %d tests slower by more than %d%%:", num_slower, CONFIG_SOAK_DRIFT_PERCENT);
+        print_drifts(slower, num_slower, NS_IN_US, "us");
+    }
+    if (num_retyped > 0) {
+        printf("  %d tests retyped more memory:", num_retyped);
+        print_drifts(retyped, num_retyped, 1, "bytes");
+    }
+    iteration++;
+}
+
+bool soak_continue(driver_env_t env)
+{
+    if (!soak_enabled() || (run_config.iterations != 0 && iteration >= run_config.iterations)) {
+        return false;
+    }
+    if (run_config.soak_time_s != 0 && config_set(CONFIG_HAVE_TIMER)) {
+        return timestamp(env) - soak_start_ns < (uint64_t)run_config.soak_time_s * NS_IN_S;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include <test_init_data.h>
+
+#include "timing.h"
+
+/* Soak mode runs the selected tests over and over without rebooting, for a
+ * number of iterations or until a time limit, set by CONFIG_SOAK_ITERATIONS
+ * and CONFIG_SOAK_TIME_LIMIT_S or by the run config. After each iteration
+ * the time each test took is compared against the first iteration, as are
+ * the memory the driver has left, the memory of the test untyped pools that
+ * is free and the caps in the provisioning cnodes, and the drift is
+ * summarised. */
+
+/* Number of tests that drifted the most to list after each iteration */
+#define NUM_SOAK_DRIFTED_TESTS 5
+
+/* Tests that took less than this longer than in the first iteration have
+ * not drifted, whatever the percentage */
+#define SOAK_DRIFT_MIN_NS (100 * NS_IN_US)
+
+struct driver_env;
+
+/* Whether the tests are run more than once */
+bool soak_enabled(void);
+
+/* Make room to keep the timing of num_tests tests in each iteration */
+void soak_init(int num_tests);
+
+void soak_start_iteration(struct driver_env *env);
+
+/* Keep the timing and usage (if not NULL) of a test, if in an iteration */
+void soak_record(const char *name, test_timing_t *timing, test_usage_t *usage);
+
+/* Print how the iteration drifted from the first one */
+void soak_end_iteration(struct driver_env *env);
+
+/* Whether to run another iteration */
+bool soak_continue(struct driver_env *env);
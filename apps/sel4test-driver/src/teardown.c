@@ -0,0 +1,185 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <utils/util.h>
+
+#include "pool.h"
+#include "provision.h"
+#include "teardown.h"
+#include "timer.h"
+#include "worker.h"
+
+/* Work out which untypeds need revoking. A test only retypes the untypeds it
+ * was handed, unless it failed, in which case it may have used any of them. */
+static void mark_dirty(driver_env_t env, untyped_pool_t *pool, test_process_t *test)
+{
+    for (int i = 0; i < pool->num_untypeds; i++) {
+        seL4_Word bit = BIT(i % seL4_WordBits);
+        if (test->failed || (test->init->untypeds_used[i / seL4_WordBits] & bit)) {
+            pool->dirty[i / seL4_WordBits] |= bit;
+            env->untyped_revokes++;
+        } else {
+            pool->dirty[i / seL4_WordBits] &= ~bit;
+            env->untyped_revokes_skipped++;
+        }
+    }
+}
+
+static void destroy_process(driver_env_t env, test_process_t *test)
+{
+    basic_destroy_process(env, test);
+    if (CONFIG_PROCESS_POOL_DEPTH > 0) {
+        pool_release(env, test);
+    }
+}
+
+/* worker job: reclaim one retired pool */
+static bool teardown_reclaim(driver_env_t env)
+{
+    driver_lock(env);
+    untyped_pool_t *pool = NULL;
+    for (int i = 0; i < env->num_untyped_pools && pool == NULL; i++) {
+        if (env->untyped_pools[i].retired != NULL && !env->untyped_pools[i].reclaiming) {
+            pool = &env->untyped_pools[i];
+        }
+    }
+    if (pool == NULL) {
+        driver_unlock(env);
+        return false;
+    }
+    pool->reclaiming = true;
+    bool revoke = !pool->retired->stopped;
+    driver_unlock(env);
+
+    /* revoking only touches caps the main thread leaves alone while the pool
+     * is retired, so it does not need the lock */
+    if (revoke) {
+        provision_revoke(env, pool);
+    }
+
+    driver_lock(env);
+    destroy_process(env, pool->retired);
+    pool->retired = NULL;
+    pool->reclaiming = false;
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        pool->reclaim_time = timestamp(env);
+    }
+    seL4_Signal(pool->reclaimed.cptr);
+    driver_unlock(env);
+
+    return true;
+}
+
+void teardown_start(driver_env_t env)
+{
+    static bool started;
+
+    if (!started) {
+        worker_add_job(teardown_reclaim);
+        worker_init(env);
+        started = true;
+    }
+}
+
+void teardown_stop_test(driver_env_t env, untyped_pool_t *pool, test_process_t *test)
+{
+    if (test->stopped) {
+        return;
+    }
+
+    uint64_t start = config_set(CONFIG_HAVE_TIMER) ? timestamp(env) : 0;
+    int error = seL4_TCB_Suspend(test->process.thread.tcb.cptr);
+    ZF_LOGF_IF(error, "Failed to suspend test process");
+
+    /* every other thread and process of the test was made from its untypeds,
+     * revoking them deletes the lot */
+    mark_dirty(env, pool, test);
+    provision_revoke(env, pool);
+    test->stopped = true;
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        pool->stop_time = timestamp(env) - start;
+    }
+}
+
+void teardown_test(driver_env_t env, untyped_pool_t *pool, test_process_t *test)
+{
+    if (!test->stopped) {
+        mark_dirty(env, pool, test);
+    }
+
+    if (!config_set(CONFIG_BACKGROUND_TEARDOWN)) {
+        if (!test->stopped) {
+            provision_revoke(env, pool);
+        }
+        destroy_process(env, test);
+        return;
+    }
+
+    /* make sure the test does nothing more until it is destroyed */
+    if (!test->stopped) {
+        int error = seL4_TCB_Suspend(test->process.thread.tcb.cptr);
+        ZF_LOGF_IF(error, "Failed to suspend finished test process");
+    }
+
+    strncpy(pool->retired_name, test->init->name, TEST_NAME_MAX);
+    pool->retired_name[TEST_NAME_MAX - 1] = '\0';
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        pool->retire_time = timestamp(env);
+    }
+    pool->retired = test;
+    worker_wake(env);
+}
+
+void teardown_untypeds(driver_env_t env, untyped_pool_t *pool, test_process_t *test)
+{
+    mark_dirty(env, pool, test);
+    provision_revoke(env, pool);
+    memset(test->init->untypeds_used, 0, sizeof(test->init->untypeds_used));
+}
+
+void teardown_wait(driver_env_t env, untyped_pool_t *pool)
+{
+    if (!config_set(CONFIG_BACKGROUND_TEARDOWN) || pool->retired_name[0] == '\0') {
+        return;
+    }
+
+    uint64_t start = config_set(CONFIG_HAVE_TIMER) ? timestamp(env) : 0;
+    bool waited = false;
+    while (pool->retired != NULL) {
+        driver_unlock(env);
+        seL4_Wait(pool->reclaimed.cptr, NULL);
+        driver_lock(env);
+        waited = true;
+    }
+
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        /* stopping a test is done by the main thread, so all of it is exposed */
+        uint64_t exposed = (waited ? timestamp(env) - start : 0) + pool->stop_time;
+        uint64_t total = pool->reclaim_time - pool->retire_time + pool->stop_time;
+        uint64_t hidden = total > exposed ? total - exposed : 0;
+        printf("Teardown of %s: %llu us hidden, %llu us exposed\n", pool->retired_name,
+               (unsigned long long)(hidden / NS_IN_US), (unsigned long long)(exposed / NS_IN_US));
+    }
+    pool->retired_name[0] = '\0';
+    pool->stop_time = 0;
+}
+
+void teardown_stop(driver_env_t env)
+{
+    for (int i = 0; i < env->num_untyped_pools; i++) {
+        teardown_wait(env, &env->untyped_pools[i]);
+    }
+
+    printf("Skipped %d of %d untyped revokes\n", env->untyped_revokes_skipped,
+           env->untyped_revokes + env->untyped_revokes_skipped);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include "test.h"
+
+/* Tearing down a BASIC test means revoking the untypeds it used and destroying
+ * its process. With CONFIG_BACKGROUND_TEARDOWN this is done by the worker
+ * thread, and the next test runs with the other untyped pool in the meantime.
+ * The main thread only waits if it needs a pool that has not been reclaimed
+ * yet.
+ *
+ * The main thread suspends the process of a finished test before handing it
+ * over. Any other threads the test left running carry on until the worker
+ * revokes the untypeds they were made from. A test that has to be stopped
+ * at once is stopped by the main thread with teardown_stop_test instead, and
+ * the time that takes is counted as exposed. */
+
+/* Start tearing down tests in the background. */
+void teardown_start(driver_env_t env);
+
+/* Stop a test and everything it created: suspend its process and revoke the
+ * untypeds it used. The process is kept until it is torn down, so that its
+ * registers can still be dumped. Does nothing if the test was already
+ * stopped. */
+void teardown_stop_test(driver_env_t env, untyped_pool_t *pool, test_process_t *test);
+
+/* Tear down the process of a finished test and reclaim the untypeds it used. */
+void teardown_test(driver_env_t env, untyped_pool_t *pool, test_process_t *test);
+
+/* Reclaim the untypeds used by a finished test whose process carries on
+ * running tests. This is always done before returning, as the process goes
+ * on with the same untypeds. */
+void teardown_untypeds(driver_env_t env, untyped_pool_t *pool, test_process_t *test);
+
+/* Wait until an untyped pool is ready for another test. */
+void teardown_wait(driver_env_t env, untyped_pool_t *pool);
+
+/* Wait until every untyped pool has been reclaimed. */
+void teardown_stop(driver_env_t env);
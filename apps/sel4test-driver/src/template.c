@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <sel4utils/process.h>
+#include <sel4utils/vspace.h>
+#include <vka/object.h>
+#include <vspace/vspace.h>
+#include <utils/util.h>
+
+#include "template.h"
+
+/* Read-only mappings, in the driver, of the writable regions of the template.
+ * These are the source of the data copied into each new test process. Regions
+ * that are not writable have no entry. */
+static void *template_data[MAX_REGIONS];
+
+static bool region_is_writable(sel4utils_elf_region_t *region)
+{
+    return seL4_CapRights_get_capAllowWrite(region->rights);
+}
+
+/* page aligned start and number of pages covered by a region */
+static uintptr_t region_start(sel4utils_elf_region_t *region)
+{
+    return ROUND_DOWN((uintptr_t) region->elf_vstart, PAGE_SIZE_4K);
+}
+
+static int region_num_pages(sel4utils_elf_region_t *region)
+{
+    uintptr_t end = ROUND_UP((uintptr_t) region->elf_vstart + region->size, PAGE_SIZE_4K);
+    return (end - region_start(region)) / PAGE_SIZE_4K;
+}
+
+void template_init(driver_env_t env)
+{
+    if (env->template_ready) {
+        return;
+    }
+
+    /* load the image into the template exactly as it would be for a test */
+    sel4utils_process_config_t config = process_config_default_simple(&env->simple, TESTS_APP, env->init->priority);
+    int error = sel4utils_configure_process_custom(&env->template_process, &env->vka, &env->vspace, config);
+    ZF_LOGF_IF(error, "Failed to load template test process");
+
+    /* keep a window onto every writable region so we can copy from it */
+    for (int i = 0; i < env->init->num_elf_regions; i++) {
+        sel4utils_elf_region_t *region = &env->init->elf_regions[i];
+        if (!region_is_writable(region)) {
+            continue;
+        }
+        template_data[i] = vspace_share_mem(&env->template_process.vspace, &env->vspace,
+                                            (void *) region_start(region), region_num_pages(region),
+                                            PAGE_BITS_4K, seL4_CanRead, 1);
+        ZF_LOGF_IF(template_data[i] == NULL, "Failed to map template region %d", i);
+    }
+
+    env->template_ready = true;
+}
+
+/* Give the process its own copy of a writable region of the template */
+static int copy_region(driver_env_t env, sel4utils_process_t *process, sel4utils_elf_region_t *region,
+                       const char *src)
+{
+    uintptr_t start = region_start(region);
+    int num_pages = region_num_pages(region);
+
+    for (int i = 0; i < num_pages; i++) {
+        vka_object_t frame;
+        int error = vka_alloc_frame(&env->vka, PAGE_BITS_4K, &frame);
+        if (error) {
+            ZF_LOGE("Failed to allocate frame for writable region");
+            return error;
+        }
+
+        /* fill the frame with the template's data through a temporary mapping */
+        void *dest = vspace_map_pages(&env->vspace, &frame.cptr, NULL, seL4_AllRights, 1, PAGE_BITS_4K, 1);
+        if (dest == NULL) {
+            ZF_LOGE("Failed to map frame into the driver");
+            vka_free_object(&env->vka, &frame);
+            return -1;
+        }
+        memcpy(dest, src + i * PAGE_SIZE_4K, PAGE_SIZE_4K);
+        vspace_unmap_pages(&env->vspace, dest, 1, PAGE_BITS_4K, NULL);
+
+        /* hand the frame over to the process, its vspace frees it on teardown */
+        uintptr_t cookie = frame.ut;
+        error = vspace_map_pages_at_vaddr(&process->vspace, &frame.cptr, &cookie,
+                                          (void *)(start + i * PAGE_SIZE_4K), 1, PAGE_BITS_4K,
+                                          region->reservation);
+        if (error) {
+            ZF_LOGE("Failed to map frame into test process");
+            vka_free_object(&env->vka, &frame);
+            return error;
+        }
+    }
+
+    return 0;
+}
+
+int template_configure_process(driver_env_t env, sel4utils_process_t *process,
+                               sel4utils_process_config_t config)
+{
+    assert(env->template_ready);
+
+    /* only reserve the regions of the image, we fill them in ourselves, or
+     * leave them to be paged in */
+    config = process_config_elf(config, TESTS_APP, false);
+    int error = sel4utils_configure_process_custom(process, &env->vka, &env->vspace, config);
+    if (error) {
+        return error;
+    }
+
+    /* regions are reserved in the same order for every process created from
+     * the same image, so they line up with the template's */
+    assert(process->num_elf_regions == env->init->num_elf_regions);
+    for (int i = 0; i < process->num_elf_regions && !error; i++) {
+        sel4utils_elf_region_t *region = &process->elf_regions[i];
+        if (region_is_writable(region)) {
+            error = copy_region(env, process, region, template_data[i]);
+        } else if (!config_set(CONFIG_DEMAND_PAGING)) {
+            void *start = (void *) region_start(region);
+            error = sel4utils_share_mem_at_vaddr(&env->template_process.vspace, &process->vspace, start,
+                                                 region_num_pages(region), PAGE_BITS_4K, start,
+                                                 region->reservation);
+        }
+    }
+
+    if (error) {
+        ZF_LOGE("Failed to populate test process from template");
+        sel4utils_destroy_process(process, &env->vka);
+    }
+    return error;
+}
+
+bool template_page_in(driver_env_t env, test_process_t *test, uintptr_t vaddr)
+{
+    sel4utils_process_t *process = &test->process;
+    void *page = (void *) ROUND_DOWN(vaddr, PAGE_SIZE_4K);
+
+    for (int i = 0; i < process->num_elf_regions; i++) {
+        sel4utils_elf_region_t *region = &process->elf_regions[i];
+        uintptr_t start = region_start(region);
+        if (region_is_writable(region) || (uintptr_t) page < start ||
+            (uintptr_t) page >= start + region_num_pages(region) * PAGE_SIZE_4K) {
+            continue;
+        }
+
+        if (vspace_get_cap(&process->vspace, page) != seL4_CapNull) {
+            /* threads that fault on the same page before it is paged in are
+             * restarted, a second fault on it is a fault of the test */
+            if (page == test->paged_in && !test->refaulted) {
+                test->refaulted = true;
+                return true;
+            }
+            return false;
+        }
+
+        int error = sel4utils_share_mem_at_vaddr(&env->template_process.vspace, &process->vspace, page, 1,
+                                                 PAGE_BITS_4K, page, region->reservation);
+        if (error) {
+            ZF_LOGE("Failed to page in %p", page);
+            return false;
+        }
+        test->paged_in = page;
+        test->refaulted = false;
+        test->init->usage.paged_in++;
+        return true;
+    }
+    return false;
+}
+
+int template_read_only_pages(driver_env_t env)
+{
+    int pages = 0;
+    for (int i = 0; i < env->init->num_elf_regions; i++) {
+        if (!region_is_writable(&env->init->elf_regions[i])) {
+            pages += region_num_pages(&env->init->elf_regions[i]);
+        }
+    }
+    return pages;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <sel4utils/process.h>
+#include "test.h"
+
+/* Load the template test process. This only needs to happen once, the
+ * template is never run and stays untouched for the lifetime of the driver. */
+void template_init(driver_env_t env);
+
+/* Configure a test process from the template rather than from the ELF file.
+ *
+ * The read-only regions of the image are shared with the template, and the
+ * writable regions are copied from it, so each test process starts with
+ * exactly the state that loading the image would have given it. */
+int template_configure_process(driver_env_t env, sel4utils_process_t *process,
+                               sel4utils_process_config_t config);
+
+/* With CONFIG_DEMAND_PAGING the read-only regions are only reserved, and
+ * their pages are shared with the template when the process faults on them.
+ * Page in the page of a faulting address, returns false if the fault is not
+ * one that paging in fixes.
+ *
+ * Helper processes fault to the same endpoint as the test. The test pages in
+ * the whole image before creating one (page_in_image), so a fault of a helper
+ * process is never on a page that is not mapped in the test, and is never
+ * paged in here. */
+bool template_page_in(driver_env_t env, test_process_t *test, uintptr_t vaddr);
+
+/* Number of pages in the read-only regions of the image */
+int template_read_only_pages(driver_env_t env);
@@ -14,14 +14,20 @@
 #include <platsupport/time_manager.h>
 #include <vka/vka.h>
 #include <vka/object.h>
+#include <sel4rpc/server.h>
 #include <sel4test/test.h>
 #include <sel4testsupport/testreporter.h>
 #include <sel4utils/process.h>
 #include <simple/simple.h>
 #include <vspace/vspace.h>
 
+#include "flaky.h"
+#include "service.h"
+#include "timing.h"
+
 /* This file is shared with seltest-tests. */
 #include <test_init_data.h>
+#include <test_select.h>
 
 #define TESTS_APP "sel4test-tests"
 
@@ -33,6 +39,83 @@ struct timer_callback_info {
 };
 typedef struct timer_callback_info timer_callback_info_t;
 
+/* A test process and the driver's view of it */
+struct test_process {
+    sel4utils_process_t process;
+    /* init data frame shared with the process, mapped in the driver */
+    test_init_data_t *init;
+    /* where the init data frame is mapped in the process */
+    void *remote_vaddr;
+    /* the fault endpoint, in the cspace of the process */
+    seL4_CPtr endpoint;
+    /* root of the cspace of the process, joining its own cnode and the
+     * provisioning cnode of its untyped pool */
+    vka_object_t root;
+    /* slot of the cap to the root cnode in the cnode of the process */
+    seL4_CPtr root_slot;
+    /* whether the test run by the process failed */
+    bool failed;
+    /* the process is suspended and its untypeds revoked (teardown_stop_test) */
+    bool stopped;
+    /* the process is waiting in seL4_Call to run its next PERSISTENT test */
+    bool waiting;
+    /* last page paged in (CONFIG_DEMAND_PAGING), and whether another thread
+     * faulted on it since */
+    void *paged_in;
+    bool refaulted;
+};
+typedef struct test_process test_process_t;
+
+/* number of tests that can run at once */
+#ifdef CONFIG_PARALLEL_TESTS
+#define MAX_TEST_SLOTS CONFIG_MAX_NUM_NODES
+#else
+#define MAX_TEST_SLOTS 1
+#endif
+
+/* background teardown uses two pools, and parallel tests one for each slot */
+#if MAX_TEST_SLOTS > 2
+#define MAX_UNTYPED_POOLS MAX_TEST_SLOTS
+#else
+#define MAX_UNTYPED_POOLS 2
+#endif
+
+/* A share of the untypeds for tests, used by one test at a time */
+struct untyped_pool {
+    vka_object_t *untypeds;
+    int num_untypeds;
+    /* the untypeds of each size are num_of_size[size_bits] untypeds from
+     * first_of_size[size_bits] on */
+    int first_of_size[seL4_WordBits];
+    int num_of_size[seL4_WordBits];
+    /* memory in the untypeds of the pool */
+    seL4_Word bytes;
+
+    /* provisioning cnode, holding copies of the untypeds of the pool and of
+     * the caps that are the same for every test */
+    vka_object_t cnode;
+    /* slot of the first untyped in the provisioning cnode */
+    seL4_Word first_untyped;
+    /* bitmap of the untypeds that need revoking before the next test */
+    seL4_Word dirty[UNTYPEDS_USED_WORDS];
+
+    /* process of the last test that used the pool, while it is waiting to
+     * be torn down by the worker (CONFIG_BACKGROUND_TEARDOWN) */
+    test_process_t *retired;
+    /* set while the worker is reclaiming the pool */
+    bool reclaiming;
+    /* signalled by the worker when it has reclaimed the pool */
+    vka_object_t reclaimed;
+
+    /* for reporting how much of the teardown was hidden */
+    char retired_name[TEST_NAME_MAX];
+    uint64_t retire_time;
+    uint64_t reclaim_time;
+    /* time the main thread spent stopping the last test (teardown_stop_test) */
+    uint64_t stop_time;
+};
+typedef struct untyped_pool untyped_pool_t;
+
 struct driver_env {
     /* An initialised vka that may be used by the test. */
     vka_t vka;
@@ -58,6 +141,11 @@ struct driver_env {
      * before actually starting them.
      */
     vka_object_t timer_notify_test;
+    /* The same for the tests in the other test slots (CONFIG_PARALLEL_TESTS),
+     * slot 0 uses timer_notify_test */
+    vka_object_t slot_timer_notify[MAX_TEST_SLOTS];
+    /* the test slot whose timer requests are being served */
+    int timer_slot;
 
     /* Only needed if we're on RT kernel */
     vka_object_t reply;
@@ -69,28 +157,103 @@ struct driver_env {
     /* timer callback information */
     timer_callback_info_t timer_cbs[MAX_TIMER_IRQS];
 
-    /* init data frame vaddr */
+    /* init data frame vaddr. Holds the parts of the init data that are the
+     * same for every test; it is also the frame used by the test process
+     * when the process pool is disabled. */
     test_init_data_t *init;
     /* extra cap to the init data frame for mapping into the remote vspace */
     seL4_CPtr init_frame_cap_copy;
 
-    void *remote_vaddr;
-    sel4utils_process_t test_process;
-    seL4_CPtr endpoint;
+    /* the process running the current BASIC test */
+    test_process_t *test;
 
     int num_untypeds;
     vka_object_t *untypeds;
 
+    /* the untypeds split into pools that tests take turns to use */
+    untyped_pool_t untyped_pools[MAX_UNTYPED_POOLS];
+    int num_untyped_pools;
+    int next_untyped_pool;
+    /* the untyped pool of the current BASIC test */
+    untyped_pool_t *test_untypeds;
+    /* number of tests that can run at once, one for each core when running
+     * tests in parallel */
+    int num_test_slots;
+    /* endpoint that tests running in parallel all report to, badged with
+     * their test slot */
+    vka_object_t parallel_endpoint;
+    /* set while BASIC tests are run in parallel */
+    bool in_parallel;
+
+    /* phases of the current test timed so far */
+    test_timing_t timing;
+    /* attempts made at the current test */
+    test_attempts_t attempts;
+    /* resources the current test used, when the test process reported them */
+    test_usage_t usage;
+    bool have_usage;
+    /* requests the driver served for the current test, and where the
+     * requests being served are counted, NULL when they are not for one
+     * test (CONFIG_REPORT_SERVICE_TIME) */
+    service_stats_t service;
+    service_stats_t *test_service;
+
+    /* _test_case section of the tests image, that tests are passed the
+     * index of their test case in */
+    testcase_t *test_cases;
+    /* deadlines of the tests that do not use CONFIG_TEST_DEADLINE_MS, from the
+     * _test_deadline section of the tests image */
+    test_deadline_t *test_deadlines;
+    int num_test_deadlines;
+    /* flaky tests, from the _test_flaky section of the tests image */
+    test_flaky_t *test_flaky;
+    int num_test_flaky;
+
+    /* untyped revokes done and skipped, as the tests did not use them */
+    int untyped_revokes;
+    int untyped_revokes_skipped;
+
     /* device frame to use for some tests */
     vka_object_t device_obj;
 
     /* time server for managing timeouts */
     time_manager_t tm;
+
+    /* pristine, never started copy of the test process that new test
+     * processes are created from (CONFIG_PROCESS_TEMPLATE) */
+    sel4utils_process_t template_process;
+    bool template_ready;
+
+    /* when the current test process started being set up */
+    uint64_t spawn_start;
+    /* how long the current test waited for a process from the pool */
+    uint64_t pool_stall;
 };
 typedef struct driver_env *driver_env_t;
 
 void plat_init(driver_env_t env) WEAK;
 
+/* Create a test process with everything it needs except its untypeds, ready
+ * to be started by the BASIC test type. */
+void basic_configure_process(driver_env_t env, test_process_t *test);
+/* Destroy a test process created by basic_configure_process */
+void basic_destroy_process(driver_env_t env, test_process_t *test);
+/* Start the current BASIC test in the process that has been set up for it */
+void basic_start_test(driver_env_t env, struct testcase *test);
+/* Handle timer interrupts received by the driver while tests run */
+void basic_handle_timer_irq(driver_env_t env, seL4_Word badge);
+/* Handle a message or fault from the process of the current BASIC test.
+ * Returns true if the test has finished, with its result in *result. */
+bool basic_handle_message(driver_env_t env, sel4rpc_server_env_t *rpc_server, seL4_MessageInfo_t info,
+                          int *result);
+/* Print the fault that ended a test, from the fault message in the MRs */
+void basic_print_fault(test_process_t *test, seL4_MessageInfo_t info, const char *name);
+/* Stop a test that has not finished by its deadline, and everything it
+ * created, and mark it failed. Its process is kept until it is torn down. */
+void basic_time_out(driver_env_t env, test_process_t *test);
+/* Print that a test ran past its deadline, and the registers of its root thread */
+void basic_print_timeout(test_process_t *test, const char *name);
+
 #ifdef CONFIG_TK1_SMMU
 seL4_SlotRegion arch_copy_iospace_caps_to_process(sel4utils_process_t *process, driver_env_t env);
 #endif
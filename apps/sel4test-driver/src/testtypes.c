@@ -12,7 +12,15 @@
 #include <vka/capops.h>
 
 #include "test.h"
+#include "parallel.h"
+#include "pool.h"
+#include "provision.h"
+#include "refill.h"
+#include "teardown.h"
+#include "template.h"
 #include "timer.h"
+#include "usage.h"
+#include "worker.h"
 #include <sel4rpc/server.h>
 #include <sel4testsupport/testreporter.h>
 
@@ -43,89 +51,138 @@ static DEFINE_TEST_TYPE(BOOTSTRAP, BOOTSTRAP,
                         bootstrap_set_up, bootstrap_tear_down, bootstrap_run_test);
 
 /* Basic test type. Each test is launched as its own process. */
-/* copy untyped caps into a processes cspace, return the cap range they can be found in */
-static seL4_SlotRegion copy_untypeds_to_process(sel4utils_process_t *process, vka_object_t *untypeds, int num_untypeds,
-                                                driver_env_t env)
+void basic_handle_timer_irq(driver_env_t env, seL4_Word badge)
 {
-    seL4_SlotRegion range = {0};
-
-    for (int i = 0; i < num_untypeds; i++) {
-        seL4_CPtr slot = sel4utils_copy_cap_to_process(process, &env->vka, untypeds[i].cptr);
-
-        /* set up the cap range */
-        if (i == 0) {
-            range.start = slot;
-        }
-        range.end = slot;
-    }
-    assert((range.end - range.start) + 1 == num_untypeds);
-    return range;
+    assert(config_set(CONFIG_HAVE_TIMER));
+
+    /* handle timer interrupts in hardware */
+    handle_timer_interrupts(env, badge);
+    /* Driver does extra work to check whether timeout succeeded and signals
+     * clients/tests
+     */
+    int error = tm_update(&env->tm);
+    ZF_LOGF_IF(error, "Failed to update time manager");
 }
 
-static void handle_timer_requests(driver_env_t env, sel4test_output_t test_output)
+bool basic_handle_message(driver_env_t env, sel4rpc_server_env_t *rpc_server, seL4_MessageInfo_t info,
+                          int *result)
 {
+    uint64_t start = service_start(env);
+    sel4test_output_t test_output = seL4_GetMR(0);
+
+    if (config_set(CONFIG_DEMAND_PAGING) && seL4_MessageInfo_get_label(info) == seL4_Fault_VMFault &&
+        template_page_in(env, env->test, seL4_GetMR(seL4_VMFault_Addr))) {
+        /* restart the thread that faulted */
+        api_reply(env->reply.cptr, seL4_MessageInfo_new(0, 0, 0, 0));
+        service_end(env, SERVICE_PAGE_IN, start);
+        return false;
+    }
 
-    seL4_MessageInfo_t info;
-    uint64_t timeServer_ns;
-    seL4_Word timeServer_timeoutType;
-
-    switch (test_output) {
-
-    case SEL4TEST_TIME_TIMEOUT:
-
-        timeServer_timeoutType = seL4_GetMR(1);
-        timeServer_ns = sel4utils_64_get_mr(2);
+    if (sel4test_isTimerRPC(test_output)) {
 
-        timeout(env, timeServer_ns, timeServer_timeoutType);
+        if (config_set(CONFIG_HAVE_TIMER)) {
+            handle_timer_requests(env, test_output);
+            service_end(env, test_output == SEL4TEST_TIME_TIMEOUT ? SERVICE_TIMEOUT :
+                        test_output == SEL4TEST_TIME_TIMESTAMP ? SERVICE_TIMESTAMP : SERVICE_TIMER_RESET, start);
+            return false;
+        } else {
+            ZF_LOGF("Requesting a timer service from sel4test-driver while there is no"
+                    "supported HW timer.");
+        }
+    } else if (test_output == SEL4TEST_PROTOBUF_RPC) {
+        sel4rpc_server_recv(rpc_server);
+        service_end(env, SERVICE_RPC, start);
+        return false;
+    }
 
-        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
+    *result = test_output;
+    if (seL4_MessageInfo_get_label(info) != seL4_Fault_NullFault) {
+        /* A test that faults before it has paged in the whole image may have
+         * faulted on a page that paging in should have given it, so the run
+         * is stopped rather than the fault blamed on the test. */
+        ZF_LOGF_IF(config_set(CONFIG_DEMAND_PAGING) &&
+                   env->test->init->usage.paged_in < (seL4_Word) template_read_only_pages(env),
+                   "Test %s faulted with %lu of %d image pages paged in", env->test->init->name,
+                   (unsigned long) env->test->init->usage.paged_in, template_read_only_pages(env));
+        *result = FAILURE;
+    }
+    service_end(env, SERVICE_RESULT, start);
+    return true;
+}
 
-        seL4_SetMR(0, 0);
-        api_reply(env->reply.cptr, info);
-        break;
+void basic_print_fault(test_process_t *test, seL4_MessageInfo_t info, const char *name)
+{
+    sel4utils_print_fault_message(info, name);
+    printf("Register of root thread in test (may not be the thread that faulted)\n");
+    sel4debug_dump_registers(test->process.thread.tcb.cptr);
+}
 
-    case SEL4TEST_TIME_TIMESTAMP:
-        timeServer_ns = timestamp(env);
-        sel4utils_64_set_mr(1, timeServer_ns);
-        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, SEL4UTILS_64_WORDS + 1);
-        seL4_SetMR(0, 0);
-        api_reply(env->reply.cptr, info);
-        break;
+void basic_time_out(driver_env_t env, test_process_t *test)
+{
+    /* so that the process is destroyed rather than reused, and all of its
+     * untypeds are revoked */
+    test->failed = true;
+    teardown_stop_test(env, env->test_untypeds, test);
+}
 
-    case SEL4TEST_TIME_RESET:
-        timer_reset(env);
-        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
-        seL4_SetMR(0, 0);
-        api_reply(env->reply.cptr, info);
-        break;
+void basic_print_timeout(test_process_t *test, const char *name)
+{
+    printf("TIMEOUT: %s did not finish by its deadline\n", name);
+    printf("Register of root thread in test (may not be the thread that hung)\n");
+    sel4debug_dump_registers(test->process.thread.tcb.cptr);
+}
 
-    default:
-        ZF_LOGF("Invalid time request");
-        break;
+/* Deadline of a test, 0 if it has none */
+static uint64_t test_deadline_ns(driver_env_t env, struct testcase *test)
+{
+    uint64_t ms = CONFIG_TEST_DEADLINE_MS;
+    for (int i = 0; i < env->num_test_deadlines; i++) {
+        if (strncmp(env->test_deadlines[i].name, test->name, TEST_NAME_MAX) == 0) {
+            ms = env->test_deadlines[i].ms;
+        }
     }
+    return ms * NS_IN_MS;
+}
 
+/* Reply to the PERSISTENT test process waiting for its next test. On MCS this
+ * is the reply object it was received on, on other kernels the saved caller. */
+#ifdef CONFIG_KERNEL_MCS
+static vka_object_t persistent_reply;
+#else
+static cspacepath_t persistent_reply;
+#endif
+
+/* Hold on to the reply to the current test, so that it can be resumed with
+ * its next test after other messages have been received */
+static void persistent_keep_reply(driver_env_t env)
+{
+#ifdef CONFIG_KERNEL_MCS
+    /* receive with a spare reply object from now on */
+    vka_object_t reply = persistent_reply;
+    persistent_reply = env->reply;
+    env->reply = reply;
+#else
+    int error = seL4_CNode_SaveCaller(persistent_reply.root, persistent_reply.capPtr, persistent_reply.capDepth);
+    ZF_LOGF_IF(error, "Failed to save reply to test process");
+#endif
 }
 
-/* This function waits on:
- * Timer interrupts (from hardware)
- * Requests from tests (sel4driver acts as a server)
- * Results from sel4test/tests
- */
 static int sel4test_driver_wait(driver_env_t env, struct testcase *test)
 {
     seL4_MessageInfo_t info;
-    sel4test_output_t test_output;
     int result = SUCCESS;
     seL4_Word badge = 0;
     sel4rpc_server_env_t rpc_server;
 
-    sel4rpc_server_init(&rpc_server, &env->vka, sel4rpc_default_handler, env,
+    sel4rpc_server_init(&rpc_server, &env->vka, refill_rpc_handler, env,
                         &env->reply, &env->simple);
+    env->test_service = &env->service;
 
     while (1) {
         /* wait for tests to finish or fault, receive test request or report result */
-        info = api_recv(env->test_process.fault_endpoint.cptr, &badge, env->reply.cptr);
-        test_output = seL4_GetMR(0);
+        driver_unlock(env);
+        info = api_recv(env->test->process.fault_endpoint.cptr, &badge, env->reply.cptr);
+        driver_lock_after_recv(env, info);
 
         /* FIXME: Assumptions made at the time of writing this code:
          * 1) fault sync EP cap has a badge of 0
@@ -138,43 +195,26 @@ static int sel4test_driver_wait(driver_env_t env, struct testcase *test)
          * that might be waiting on it.
          */
         if (badge != 0) {
-            assert(config_set(CONFIG_HAVE_TIMER));
-        }
-
-        if (config_set(CONFIG_HAVE_TIMER) && badge != 0) {
-            /* handle timer interrupts in hardware */
-            handle_timer_interrupts(env, badge);
-            /* Driver does extra work to check whether timeout succeeded and signals
-             * clients/tests
-             */
-            int error = tm_update(&env->tm);
-            ZF_LOGF_IF(error, "Failed to update time manager");
-            continue;
-        }
-
-        if (sel4test_isTimerRPC(test_output)) {
-
-            if (config_set(CONFIG_HAVE_TIMER)) {
-                handle_timer_requests(env, test_output);
+            uint64_t start = service_start(env);
+            basic_handle_timer_irq(env, badge);
+            service_end(env, SERVICE_IRQ, start);
+            if (!watchdog_has_expired(env, env->timer_slot)) {
                 continue;
-            } else {
-                ZF_LOGF("Requesting a timer service from sel4test-driver while there is no"
-                        "supported HW timer.");
             }
-        } else if (test_output == SEL4TEST_PROTOBUF_RPC) {
-            sel4rpc_server_recv(&rpc_server);
-            continue;
-        }
-
-        result = test_output;
-        if (seL4_MessageInfo_get_label(info) != seL4_Fault_NullFault) {
-            sel4utils_print_fault_message(info, test->name);
-            printf("Register of root thread in test (may not be the thread that faulted)\n");
-            sel4debug_dump_registers(env->test_process.thread.tcb.cptr);
+            basic_time_out(env, env->test);
+            basic_print_timeout(env->test, test->name);
             result = FAILURE;
+        } else if (!basic_handle_message(env, &rpc_server, info, &result)) {
+            continue;
+        } else if (seL4_MessageInfo_get_label(info) != seL4_Fault_NullFault) {
+            basic_print_fault(env->test, info, test->name);
+        } else if (seL4_MessageInfo_get_length(info) > 1 && seL4_GetMR(1) == TEST_WAITING_FOR_NEXT) {
+            env->test->waiting = true;
+            persistent_keep_reply(env);
         }
 
         if (config_set(CONFIG_HAVE_TIMER)) {
+            watchdog_disarm(env);
             timer_cleanup(env);
         }
 
@@ -182,116 +222,267 @@ static int sel4test_driver_wait(driver_env_t env, struct testcase *test)
     }
 }
 
-void basic_set_up(uintptr_t e)
+/* processes used for tests when the process pool is disabled, one for each
+ * untyped pool */
+static test_process_t basic_processes[MAX_UNTYPED_POOLS];
+
+void basic_set_up_test_type(uintptr_t e)
 {
-    int error;
     driver_env_t env = (driver_env_t)e;
 
+    if (config_set(CONFIG_PROCESS_TEMPLATE)) {
+        template_init(env);
+        usage_set_image_pages(template_read_only_pages(env));
+    }
+    if (CONFIG_PROCESS_POOL_DEPTH > 0) {
+        pool_start(env);
+    }
+    if (config_set(CONFIG_BACKGROUND_TEARDOWN)) {
+        teardown_start(env);
+    }
+}
+
+void basic_tear_down_test_type(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    teardown_stop(env);
+    if (CONFIG_PROCESS_POOL_DEPTH > 0) {
+        pool_stop(env);
+    }
+}
+
+void basic_configure_process(driver_env_t env, test_process_t *test)
+{
+    int error;
+    test_init_data_t *init = test->init;
+
     sel4utils_process_config_t config = process_config_default_simple(&env->simple, TESTS_APP, env->init->priority);
     config = process_config_mcp(config, seL4_MaxPrio);
     config = process_config_auth(config, simple_get_tcb(&env->simple));
     config = process_config_create_cnode(config, TEST_PROCESS_CSPACE_SIZE_BITS);
-    error = sel4utils_configure_process_custom(&(env->test_process), &env->vka, &env->vspace, config);
+    if (config_set(CONFIG_PROCESS_TEMPLATE)) {
+        error = template_configure_process(env, &test->process, config);
+    } else {
+        error = sel4utils_configure_process_custom(&test->process, &env->vka, &env->vspace, config);
+    }
     assert(error == 0);
 
+    test->stopped = false;
+    test->waiting = false;
+    test->paged_in = NULL;
+    test->refaulted = false;
+
     /* set up caps about the process */
-    env->init->stack_pages = CONFIG_SEL4UTILS_STACK_SIZE / PAGE_SIZE_4K;
-    env->init->stack = env->test_process.thread.stack_top - CONFIG_SEL4UTILS_STACK_SIZE;
-    env->init->page_directory = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, env->test_process.pd.cptr);
-    env->init->root_cnode = SEL4UTILS_CNODE_SLOT;
-    env->init->tcb = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, env->test_process.thread.tcb.cptr);
+    init->stack_pages = CONFIG_SEL4UTILS_STACK_SIZE / PAGE_SIZE_4K;
+    init->stack = test->process.thread.stack_top - CONFIG_SEL4UTILS_STACK_SIZE;
+    init->page_directory = sel4utils_copy_cap_to_process(&test->process, &env->vka, test->process.pd.cptr);
+    init->tcb = sel4utils_copy_cap_to_process(&test->process, &env->vka, test->process.thread.tcb.cptr);
     if (config_set(CONFIG_HAVE_TIMER)) {
-        env->init->timer_ntfn = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, env->timer_notify_test.cptr);
+        init->timer_ntfn = sel4utils_copy_cap_to_process(&test->process, &env->vka, env->timer_notify_test.cptr);
     }
-
-    env->init->domain = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, simple_get_init_cap(&env->simple,
-                                                                                                           seL4_CapDomain));
-    env->init->asid_pool = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, simple_get_init_cap(&env->simple,
-                                                                                                              seL4_CapInitThreadASIDPool));
-    env->init->asid_ctrl = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, simple_get_init_cap(&env->simple,
-                                                                                                              seL4_CapASIDControl));
-#ifdef CONFIG_IOMMU
-    env->init->io_space = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, simple_get_init_cap(&env->simple,
-                                                                                                             seL4_CapIOSpace));
-#endif /* CONFIG_IOMMU */
 #ifdef CONFIG_TK1_SMMU
-    env->init->io_space_caps = arch_copy_iospace_caps_to_process(&(env->test_process), &env);
+    init->io_space_caps = arch_copy_iospace_caps_to_process(&test->process, env);
 #endif
-    env->init->cores = simple_get_core_count(&env->simple);
-    /* copy the sched ctrl caps to the remote process */
-    if (config_set(CONFIG_KERNEL_MCS)) {
-        seL4_CPtr sched_ctrl = simple_get_sched_ctrl(&env->simple, 0);
-        env->init->sched_ctrl = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, sched_ctrl);
-        for (int i = 1; i < env->init->cores; i++) {
-            sched_ctrl = simple_get_sched_ctrl(&env->simple, i);
-            sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, sched_ctrl);
-        }
-    }
-#ifdef CONFIG_ALLOW_SMC_CALLS
-    env->init->smc = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, simple_get_init_cap(&env->simple,
-                                                                                                        seL4_CapSMC));
-#endif /* CONFIG_ALLOW_SMC_CALLS */
 
-    /* setup data about untypeds */
-    env->init->untypeds = copy_untypeds_to_process(&(env->test_process), env->untypeds, env->num_untypeds, env);
     /* copy the fault endpoint - we wait on the endpoint for a message
      * or a fault to see when the test finishes */
-    env->endpoint = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, env->test_process.fault_endpoint.cptr);
+    test->endpoint = sel4utils_copy_cap_to_process(&test->process, &env->vka, test->process.fault_endpoint.cptr);
 
     /* copy the device frame, if any */
-    if (env->init->device_frame_cap) {
-        env->init->device_frame_cap = sel4utils_copy_cap_to_process(&(env->test_process), &env->vka, env->device_obj.cptr);
+    if (init->device_frame_cap) {
+        init->device_frame_cap = sel4utils_copy_cap_to_process(&test->process, &env->vka, env->device_obj.cptr);
     }
 
+    /* the rest of the caps are found through the root cnode */
+    provision_install(env, test);
+
     /* map the cap into remote vspace */
-    env->remote_vaddr = vspace_share_mem(&env->vspace, &(env->test_process).vspace, env->init, 1, PAGE_BITS_4K,
-                                         seL4_AllRights, 1);
-    assert(env->remote_vaddr != 0);
+    test->remote_vaddr = vspace_share_mem(&env->vspace, &test->process.vspace, init, TEST_INIT_DATA_PAGES,
+                                          PAGE_BITS_4K, seL4_AllRights, 1);
+    assert(test->remote_vaddr != 0);
+
+    /* set up args for the test process */
+    seL4_Word argc = 2;
+    char string_args[argc][WORD_STRING_SIZE];
+    char *argv[argc];
+    sel4utils_create_word_args(string_args, argv, argc, test->endpoint, test->remote_vaddr);
+
+    /* spawn the process, it is resumed once it has a test to run */
+    error = sel4utils_spawn_process_v(&test->process, &env->vka, &env->vspace, argc, argv, 0);
+    ZF_LOGF_IF(error != 0, "Failed to spawn test process!");
+}
+
+void basic_destroy_process(driver_env_t env, test_process_t *test)
+{
+    provision_remove(env, test);
+
+    /* unmap the init data frame */
+    vspace_unmap_pages(&test->process.vspace, test->remote_vaddr, TEST_INIT_DATA_PAGES, PAGE_BITS_4K, NULL);
+
+    /* destroy the process */
+    sel4utils_destroy_process(&test->process, &env->vka);
+}
+
+void basic_set_up(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    if (config_set(CONFIG_REPORT_SPAWN_TIME)) {
+        env->spawn_start = timestamp(env);
+    }
+
+    /* take the next untyped pool, once the last test to use it is torn down.
+     * Tests running in parallel each have the pool of their test slot. */
+    int pool_index = env->next_untyped_pool;
+    if (env->in_parallel) {
+        pool_index = env->timer_slot;
+    } else {
+        env->next_untyped_pool = (env->next_untyped_pool + 1) % env->num_untyped_pools;
+    }
+    untyped_pool_t *pool = &env->untyped_pools[pool_index];
+    teardown_wait(env, pool);
+    env->test_untypeds = pool;
+
+    if (CONFIG_PROCESS_POOL_DEPTH > 0) {
+        uint64_t start = config_set(CONFIG_HAVE_TIMER) ? timestamp(env) : 0;
+        env->test = pool_take(env);
+        env->pool_stall = config_set(CONFIG_HAVE_TIMER) ? timestamp(env) - start : 0;
+    } else {
+        /* the process of the last test to use this pool is gone by now */
+        env->test = &basic_processes[pool_index];
+        if (pool_index == 0) {
+            env->test->init = env->init;
+        } else {
+            /* processes of different pools can exist at the same time, so
+             * each needs its own init data */
+            if (env->test->init == NULL) {
+                env->test->init = vspace_new_pages(&env->vspace, seL4_AllRights, TEST_INIT_DATA_PAGES,
+                                                   PAGE_BITS_4K);
+                ZF_LOGF_IF(env->test->init == NULL, "Failed to allocate init data for test process");
+            }
+            memcpy(env->test->init, env->init, sizeof(test_init_data_t));
+        }
+        basic_configure_process(env, env->test);
+    }
+    test_init_data_t *init = env->test->init;
+
+    /* setup data about untypeds */
+    provision_attach(env, env->test, pool);
+    memset(init->untypeds_used, 0, sizeof(init->untypeds_used));
+    init->output = NULL;
+
+#ifdef CONFIG_PARALLEL_TESTS
+    if (env->in_parallel) {
+        parallel_join_slot(env, env->test, env->timer_slot);
+    }
+#endif
 
     /* WARNING: DO NOT COPY MORE CAPS TO THE PROCESS BEYOND THIS POINT,
      * AS THE SLOTS WILL BE CONSIDERED FREE AND OVERRIDDEN BY THE TEST PROCESS. */
     /* set up free slot range */
-    env->init->cspace_size_bits = TEST_PROCESS_CSPACE_SIZE_BITS;
-    if (env->init->device_frame_cap) {
-        env->init->free_slots.start = env->init->device_frame_cap + 1;
-    } else {
-        env->init->free_slots.start = env->endpoint + 1;
-    }
-    env->init->free_slots.end = (1u << TEST_PROCESS_CSPACE_SIZE_BITS);
-    assert(env->init->free_slots.start < env->init->free_slots.end);
+    init->free_slots.start = env->test->process.cspace_next_free;
+    init->free_slots.end = (1u << TEST_PROCESS_CSPACE_SIZE_BITS);
+    assert(init->free_slots.start < init->free_slots.end);
 }
 
-test_result_t basic_run_test(struct testcase *test, uintptr_t e)
+/* Tell the process of the current test which test to run */
+static void set_test_name(driver_env_t env, struct testcase *test)
 {
-    int error;
-    driver_env_t env = (driver_env_t)e;
+    test_init_data_t *init = env->test->init;
 
     /* copy test name */
-    strncpy(env->init->name, test->name, TEST_NAME_MAX);
+    strncpy(init->name, test->name, TEST_NAME_MAX);
     /* ensure string is null terminated */
-    env->init->name[TEST_NAME_MAX - 1] = '\0';
+    init->name[TEST_NAME_MAX - 1] = '\0';
+    memset(&init->usage, 0, sizeof(init->usage));
+    /* the untypeds of the last test have been revoked by now */
+    refill_seed(env, env->test_untypeds);
+    /* so the test does not have to search for itself */
+    init->test_index = test - env->test_cases;
 #ifdef CONFIG_DEBUG_BUILD
-    seL4_DebugNameThread(env->test_process.thread.tcb.cptr, env->init->name);
+    seL4_DebugNameThread(env->test->process.thread.tcb.cptr, init->name);
 #endif
+}
 
-    /* set up args for the test process */
-    seL4_Word argc = 2;
-    char string_args[argc][WORD_STRING_SIZE];
-    char *argv[argc];
-    sel4utils_create_word_args(string_args, argv, argc, env->endpoint, env->remote_vaddr);
+void basic_start_test(driver_env_t env, struct testcase *test)
+{
+    int error;
 
-    /* spawn the process */
-    error = sel4utils_spawn_process_v(&(env->test_process), &env->vka, &env->vspace,
-                                      argc, argv, 1);
+    set_test_name(env, test);
+
+    /* start the process */
+    error = seL4_TCB_Resume(env->test->process.thread.tcb.cptr);
     ZF_LOGF_IF(error != 0, "Failed to start test process!");
 
+    if (config_set(CONFIG_REPORT_SPAWN_TIME)) {
+        uint64_t spawn_time = timestamp(env) - env->spawn_start;
+        printf("Spawned %s in %llu us%s\n", test->name, (unsigned long long)(spawn_time / NS_IN_US),
+               config_set(CONFIG_PROCESS_TEMPLATE) ? " (from template)" : "");
+    }
+    if (CONFIG_PROCESS_POOL_DEPTH > 0 && config_set(CONFIG_HAVE_TIMER)) {
+        printf("%s waited %llu us for a test process\n", test->name,
+               (unsigned long long)(env->pool_stall / NS_IN_US));
+    }
+
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        error = tm_alloc_id_at(&env->tm, TIMER_ID + env->timer_slot);
+        ZF_LOGF_IF(error != 0, "Failed to alloc time id %d", TIMER_ID + env->timer_slot);
+        watchdog_arm(env, test_deadline_ns(env, test));
+    }
+}
+
+/* Undo what the last test may have changed about the thread of its process,
+ * which it can do with the TCB cap it is given */
+static void persistent_reset_thread(driver_env_t env, test_process_t *test)
+{
+    seL4_CPtr tcb = test->process.thread.tcb.cptr;
+    int error = seL4_TCB_SetMCPriority(tcb, simple_get_tcb(&env->simple), seL4_MaxPrio);
+    ZF_LOGF_IF(error, "Failed to reset MCP of test process");
+    error = seL4_TCB_SetPriority(tcb, simple_get_tcb(&env->simple), env->init->priority);
+    ZF_LOGF_IF(error, "Failed to reset priority of test process");
+    provision_set_space(env, test);
+}
+
+/* Run the next test in the PERSISTENT test process, which is waiting for it */
+static void persistent_continue_test(driver_env_t env, struct testcase *test)
+{
+    set_test_name(env, test);
+    persistent_reset_thread(env, env->test);
+
     if (config_set(CONFIG_HAVE_TIMER)) {
-        error = tm_alloc_id_at(&env->tm, TIMER_ID);
-        ZF_LOGF_IF(error != 0, "Failed to alloc time id %d", TIMER_ID);
+        int error = tm_alloc_id_at(&env->tm, TIMER_ID + env->timer_slot);
+        ZF_LOGF_IF(error != 0, "Failed to alloc time id %d", TIMER_ID + env->timer_slot);
+        watchdog_arm(env, test_deadline_ns(env, test));
+    }
+
+    /* a send on the reply cap replies to the seL4_Call */
+#ifdef CONFIG_KERNEL_MCS
+    seL4_CPtr reply = persistent_reply.cptr;
+#else
+    seL4_CPtr reply = persistent_reply.capPtr;
+#endif
+    env->test->waiting = false;
+    seL4_Send(reply, seL4_MessageInfo_new(0, 0, 0, 0));
+}
+
+test_result_t basic_run_test(struct testcase *test, uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    if (env->test->waiting) {
+        persistent_continue_test(env, test);
+    } else {
+        basic_start_test(env, test);
     }
 
     /* wait on it to finish or fault, report result */
     int result = sel4test_driver_wait(env, test);
+    env->test->failed = result != SUCCESS;
+    if (config_set(CONFIG_REPORT_RESOURCES)) {
+        env->usage = env->test->init->usage;
+        env->have_usage = true;
+    }
 
     test_assert(result == SUCCESS);
 
@@ -301,19 +492,91 @@ test_result_t basic_run_test(struct testcase *test, uintptr_t e)
 void basic_tear_down(uintptr_t e)
 {
     driver_env_t env = (driver_env_t)e;
-    /* unmap the env->init data frame */
-    vspace_unmap_pages(&(env->test_process).vspace, env->remote_vaddr, 1, PAGE_BITS_4K, NULL);
-
-    /* reset all the untypeds for the next test */
-    for (int i = 0; i < env->num_untypeds; i++) {
-        cspacepath_t path;
-        vka_cspace_make_path(&env->vka, env->untypeds[i].cptr, &path);
-        vka_cnode_revoke(&path);
+
+    /* reset the untypeds for a later test and destroy the process */
+    teardown_test(env, env->test_untypeds, env->test);
+    env->test = NULL;
+    env->test_untypeds = NULL;
+}
+
+DEFINE_TEST_TYPE(BASIC, BASIC, basic_set_up_test_type, basic_tear_down_test_type, basic_set_up, basic_tear_down,
+                 basic_run_test);
+
+/* Persistent test type. Tests run one after another in the same process, which
+ * only has its untypeds revoked between tests. A new process is only created
+ * for the first test and after a test that faulted. */
+
+/* process kept for the next test, and its untyped pool */
+static test_process_t *persistent_test;
+static untyped_pool_t *persistent_pool;
+
+static void persistent_set_up_test_type(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+    int error;
+
+    basic_set_up_test_type(e);
+
+#ifdef CONFIG_KERNEL_MCS
+    error = vka_alloc_reply(&env->vka, &persistent_reply);
+#else
+    error = vka_cspace_alloc_path(&env->vka, &persistent_reply);
+#endif
+    ZF_LOGF_IF(error, "Failed to allocate reply for persistent tests");
+}
+
+static void persistent_tear_down_test_type(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    if (persistent_test != NULL) {
+        teardown_test(env, persistent_pool, persistent_test);
+        persistent_test = NULL;
+        persistent_pool = NULL;
     }
+    /* give the reply back, so that the test type can be set up again */
+#ifdef CONFIG_KERNEL_MCS
+    vka_free_object(&env->vka, &persistent_reply);
+#else
+    /* a reply that was never used is still in its slot */
+    vka_cnode_delete(&persistent_reply);
+    vka_cspace_free_path(&env->vka, persistent_reply);
+#endif
+    basic_tear_down_test_type(e);
+}
 
-    /* destroy the process */
-    sel4utils_destroy_process(&(env->test_process), &env->vka);
+static void persistent_set_up(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    if (persistent_test == NULL) {
+        basic_set_up(e);
+        return;
+    }
+
+    /* carry on in the kept process, with the untypeds it already has */
+    env->test = persistent_test;
+    env->test_untypeds = persistent_pool;
 }
 
-DEFINE_TEST_TYPE(BASIC, BASIC, NULL, NULL, basic_set_up, basic_tear_down, basic_run_test);
+static void persistent_tear_down(uintptr_t e)
+{
+    driver_env_t env = (driver_env_t)e;
+
+    if (env->test->waiting) {
+        /* keep the process for the next test */
+        teardown_untypeds(env, env->test_untypeds, env->test);
+        persistent_test = env->test;
+        persistent_pool = env->test_untypeds;
+        env->test = NULL;
+        env->test_untypeds = NULL;
+    } else {
+        /* the test faulted, the next test gets a new process */
+        persistent_test = NULL;
+        persistent_pool = NULL;
+        basic_tear_down(e);
+    }
+}
 
+DEFINE_TEST_TYPE(PERSISTENT, PERSISTENT, persistent_set_up_test_type, persistent_tear_down_test_type,
+                 persistent_set_up, persistent_tear_down, basic_run_test);
@@ -6,6 +6,7 @@
 #include <autoconf.h>
 #include <sel4test-driver/gen_config.h>
 #include <sel4/sel4.h>
+#include <stdio.h>
 #include "timer.h"
 #include <utils/util.h>
 #include <sel4testsupport/testreporter.h>
@@ -16,16 +17,41 @@ struct sel4test_ack_data {
 };
 typedef struct sel4test_ack_data sel4test_ack_data_t;
 
-/* A pending timeout requests from tests */
-static bool timeServer_timeoutPending = false;
-static timeout_type_t timeServer_timeoutType;
+/* Ack tokens of the timer IRQs, indexed by badge bit. An IRQ is not delivered
+ * again until it is acked, so each needs at most one. */
+static sel4test_ack_data_t timer_acks[MAX_TIMER_IRQS];
+
+/* Deliveries of each timer IRQ, and the time from reading the timer when the
+ * driver picks the IRQ up to its callback returning. Reading the timer costs
+ * an MMIO access or more on most platforms, so the time is only taken with
+ * CONFIG_REPORT_SERVICE_TIME. */
+static uint64_t irq_count[MAX_TIMER_IRQS];
+static uint64_t irq_latency_ns[MAX_TIMER_IRQS];
+static uint64_t irq_max_latency_ns[MAX_TIMER_IRQS];
+
+/* A pending timeout requests from tests, one for each test slot */
+static driver_env_t timeServer_env;
+static bool timeServer_timeoutPending[MAX_TEST_SLOTS];
+static timeout_type_t timeServer_timeoutType[MAX_TEST_SLOTS];
+
+/* timer id of the test slot the driver is serving */
+static int timer_id(driver_env_t env)
+{
+    return TIMER_ID + env->timer_slot;
+}
+
+seL4_CPtr timer_slot_notification(driver_env_t env, int slot)
+{
+    return slot == 0 ? env->timer_notify_test.cptr : env->slot_timer_notify[slot].cptr;
+}
 
 static int timeout_cb(uintptr_t token)
 {
-    seL4_Signal((seL4_CPtr) token);
+    int slot = (int) token;
+    seL4_Signal(timer_slot_notification(timeServer_env, slot));
 
-    if (timeServer_timeoutType != TIMEOUT_PERIODIC) {
-        timeServer_timeoutPending = false;
+    if (timeServer_timeoutType[slot] != TIMEOUT_PERIODIC) {
+        timeServer_timeoutPending[slot] = false;
     }
     return 0;
 }
@@ -42,22 +68,25 @@ static int ack_timer_interrupts(void *ack_data)
     int error = seL4_IRQHandler_Ack(env->timer_irqs[nth_timer].handler_path.capPtr);
     ZF_LOGF_IF(error, "Failed to acknowledge timer IRQ handler");
 
-    ps_free(&env->ops.malloc_ops, sizeof(sel4test_ack_data_t), ack_data);
     return error;
 }
 
 void handle_timer_interrupts(driver_env_t env, seL4_Word badge)
 {
-    int error = 0;
     while (badge) {
         seL4_Word badge_bit = CTZL(badge);
-        sel4test_ack_data_t *ack_data = NULL;
-        error = ps_calloc(&env->ops.malloc_ops, 1, sizeof(sel4test_ack_data_t), (void **) &ack_data);
-        ZF_LOGF_IF(error, "Failed to allocate memory for ack token");
+        uint64_t start = config_set(CONFIG_REPORT_SERVICE_TIME) ? timestamp(env) : 0;
+        sel4test_ack_data_t *ack_data = &timer_acks[badge_bit];
         ack_data->env = env;
         ack_data->nth_timer = (int) badge_bit;
         env->timer_cbs[badge_bit].callback(env->timer_cbs[badge_bit].callback_data,
                                            ack_timer_interrupts, ack_data);
+        irq_count[badge_bit]++;
+        if (config_set(CONFIG_REPORT_SERVICE_TIME)) {
+            uint64_t latency = timestamp(env) - start;
+            irq_latency_ns[badge_bit] += latency;
+            irq_max_latency_ns[badge_bit] = MAX(irq_max_latency_ns[badge_bit], latency);
+        }
         badge &= ~BIT(badge_bit);
     }
 }
@@ -78,14 +107,16 @@ void wait_for_timer_interrupt(driver_env_t env)
 void timeout(driver_env_t env, uint64_t ns, timeout_type_t timeout_type)
 {
     if (config_set(CONFIG_HAVE_TIMER)) {
-        ZF_LOGD_IF(timeServer_timeoutPending, "Overwriting a previous timeout request");
-        timeServer_timeoutType = timeout_type;
+        int slot = env->timer_slot;
+        ZF_LOGD_IF(timeServer_timeoutPending[slot], "Overwriting a previous timeout request");
+        timeServer_env = env;
+        timeServer_timeoutType[slot] = timeout_type;
         int error = tm_register_cb(&env->tm, timeout_type, ns, 0,
-                                   TIMER_ID, timeout_cb, env->timer_notify_test.cptr);
+                                   timer_id(env), timeout_cb, slot);
         if (error == ETIME) {
-            error = timeout_cb(env->timer_notify_test.cptr);
+            error = timeout_cb(slot);
         } else {
-            timeServer_timeoutPending = true;
+            timeServer_timeoutPending[slot] = true;
         }
         ZF_LOGF_IF(error != 0, "register_cb failed");
     } else {
@@ -96,9 +127,9 @@ void timeout(driver_env_t env, uint64_t ns, timeout_type_t timeout_type)
 void timer_reset(driver_env_t env)
 {
     if (config_set(CONFIG_HAVE_TIMER)) {
-        int error = tm_deregister_cb(&env->tm, TIMER_ID);
+        int error = tm_deregister_cb(&env->tm, timer_id(env));
         ZF_LOGF_IF(error, "ltimer_rest failed");
-        timeServer_timeoutPending = false;
+        timeServer_timeoutPending[env->timer_slot] = false;
     } else {
         ZF_LOGF("There is no timer configured for this target");
     }
@@ -117,9 +148,119 @@ uint64_t timestamp(driver_env_t env)
     return time;
 }
 
+void handle_timer_requests(driver_env_t env, sel4test_output_t test_output)
+{
+
+    seL4_MessageInfo_t info;
+    uint64_t timeServer_ns;
+    seL4_Word timeServer_timeoutType;
+
+    switch (test_output) {
+
+    case SEL4TEST_TIME_TIMEOUT:
+
+        timeServer_timeoutType = seL4_GetMR(1);
+        timeServer_ns = sel4utils_64_get_mr(2);
+
+        timeout(env, timeServer_ns, timeServer_timeoutType);
+
+        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
+
+        seL4_SetMR(0, 0);
+        api_reply(env->reply.cptr, info);
+        break;
+
+    case SEL4TEST_TIME_TIMESTAMP:
+        timeServer_ns = timestamp(env);
+        sel4utils_64_set_mr(1, timeServer_ns);
+        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, SEL4UTILS_64_WORDS + 1);
+        seL4_SetMR(0, 0);
+        api_reply(env->reply.cptr, info);
+        break;
+
+    case SEL4TEST_TIME_RESET:
+        timer_reset(env);
+        info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
+        seL4_SetMR(0, 0);
+        api_reply(env->reply.cptr, info);
+        break;
+
+    default:
+        ZF_LOGF("Invalid time request");
+        break;
+    }
+
+}
+
+/* The watchdogs of the test slots have the timer ids after the timer ids of
+ * the test slots */
+static bool watchdog_expired[MAX_TEST_SLOTS];
+
+static int watchdog_id(driver_env_t env, int slot)
+{
+    return TIMER_ID + env->num_test_slots + slot;
+}
+
+static int watchdog_cb(uintptr_t token)
+{
+    watchdog_expired[token] = true;
+    return 0;
+}
+
+void watchdog_init(driver_env_t env)
+{
+    for (int i = 0; i < env->num_test_slots; i++) {
+        int error = tm_alloc_id_at(&env->tm, watchdog_id(env, i));
+        ZF_LOGF_IF(error, "Failed to alloc time id %d", watchdog_id(env, i));
+    }
+}
+
+void watchdog_arm(driver_env_t env, uint64_t ns)
+{
+    int slot = env->timer_slot;
+    watchdog_expired[slot] = false;
+    if (ns == 0) {
+        return;
+    }
+
+    int error = tm_register_cb(&env->tm, TIMEOUT_RELATIVE, ns, 0, watchdog_id(env, slot), watchdog_cb, slot);
+    if (error == ETIME) {
+        error = watchdog_cb(slot);
+    }
+    ZF_LOGF_IF(error, "Failed to arm watchdog of test slot %d", slot);
+}
+
+void watchdog_disarm(driver_env_t env)
+{
+    int error = tm_deregister_cb(&env->tm, watchdog_id(env, env->timer_slot));
+    ZF_LOGF_IF(error, "Failed to disarm watchdog of test slot %d", env->timer_slot);
+    watchdog_expired[env->timer_slot] = false;
+}
+
+bool watchdog_has_expired(driver_env_t env, int slot)
+{
+    return watchdog_expired[slot];
+}
+
 void timer_cleanup(driver_env_t env)
 {
     ZF_LOGF_IF(!config_set(CONFIG_HAVE_TIMER), "There is no timer configured for this target");
-    tm_free_id(&env->tm, TIMER_ID);
-    timeServer_timeoutPending = false;
+    tm_free_id(&env->tm, timer_id(env));
+    timeServer_timeoutPending[env->timer_slot] = false;
+}
+
+void timer_print_irq_summary(void)
+{
+    for (int i = 0; i < MAX_TIMER_IRQS; i++) {
+        if (irq_count[i] == 0) {
+            continue;
+        }
+        if (config_set(CONFIG_REPORT_SERVICE_TIME)) {
+            printf("Timer IRQ %d: %llu delivered, mean %llu ns, max %llu ns from pick up to callback done\n", i,
+                   (unsigned long long) irq_count[i], (unsigned long long)(irq_latency_ns[i] / irq_count[i]),
+                   (unsigned long long) irq_max_latency_ns[i]);
+        } else {
+            printf("Timer IRQ %d: %llu delivered\n", i, (unsigned long long) irq_count[i]);
+        }
+    }
 }
@@ -18,3 +18,17 @@ void timeout(driver_env_t env, uint64_t ns, timeout_type_t timeout);
 uint64_t timestamp(driver_env_t env);
 void timer_reset(driver_env_t env);
 void timer_cleanup(driver_env_t env);
+/* Serve a timer request (SEL4TEST_TIME_*) of a test and reply to it */
+void handle_timer_requests(driver_env_t env, sel4test_output_t test_output);
+/* The watchdog of a test slot stops a test that has not finished by its
+ * deadline. watchdog_arm and watchdog_disarm act on the current test slot. */
+void watchdog_init(driver_env_t env);
+/* arm the watchdog to expire in ns, or not at all if ns is 0 */
+void watchdog_arm(driver_env_t env, uint64_t ns);
+void watchdog_disarm(driver_env_t env);
+bool watchdog_has_expired(driver_env_t env, int slot);
+/* notification that the timer signals for tests in a test slot */
+seL4_CPtr timer_slot_notification(driver_env_t env, int slot);
+/* Print how many times each timer IRQ was delivered, and with
+ * CONFIG_REPORT_SERVICE_TIME how long the driver took to handle it */
+void timer_print_irq_summary(void);
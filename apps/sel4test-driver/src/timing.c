@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/util.h>
+
+#include "timer.h"
+#include "timing.h"
+
+typedef struct {
+    const char *name;
+    test_timing_t timing;
+} timing_record_t;
+
+static timing_record_t *records;
+static int num_records;
+static int max_records;
+
+void timing_start(driver_env_t env, test_timing_t *timing)
+{
+    memset(timing, 0, sizeof(*timing));
+    if (config_set(CONFIG_HAVE_TIMER)) {
+        timing->timed = true;
+        timing->mark = timestamp(env);
+    }
+}
+
+void timing_restart(driver_env_t env, test_timing_t *timing)
+{
+    if (timing->timed) {
+        timing->mark = timestamp(env);
+    }
+}
+
+void timing_end_phase(driver_env_t env, test_timing_t *timing, test_phase_t phase)
+{
+    if (timing->timed) {
+        uint64_t now = timestamp(env);
+        timing->phase_ns[phase] += now - timing->mark;
+        timing->mark = now;
+    }
+}
+
+uint64_t timing_total(test_timing_t *timing)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < NUM_TEST_PHASES; i++) {
+        total += timing->phase_ns[i];
+    }
+    return total;
+}
+
+void timing_init(int num_tests)
+{
+    records = calloc(num_tests, sizeof(timing_record_t));
+    ZF_LOGF_IF(num_tests > 0 && records == NULL, "Failed to allocate test timings");
+    max_records = num_tests;
+    num_records = 0;
+}
+
+void timing_record(const char *name, test_timing_t *timing)
+{
+    if (!timing->timed) {
+        return;
+    }
+    if (num_records == max_records) {
+        /* more tests can be recorded than were counted at boot */
+        int max = MAX(2 * max_records, 16);
+        timing_record_t *more = realloc(records, max * sizeof(timing_record_t));
+        ZF_LOGF_IF(more == NULL, "Failed to allocate test timings");
+        records = more;
+        max_records = max;
+    }
+    records[num_records].name = name;
+    records[num_records].timing = *timing;
+    num_records++;
+}
+
+static int slowest_first(const void *a, const void *b)
+{
+    uint64_t time_a = timing_total(&((timing_record_t *) a)->timing);
+    uint64_t time_b = timing_total(&((timing_record_t *) b)->timing);
+    return time_a < time_b ? 1 : time_a > time_b ? -1 : 0;
+}
+
+static void print_record(timing_record_t *record)
+{
+    printf("  %-24s %8llu us (set up %llu, run %llu, tear down %llu)\n", record->name,
+           (unsigned long long)(timing_total(&record->timing) / NS_IN_US),
+           (unsigned long long)(record->timing.phase_ns[PHASE_SET_UP] / NS_IN_US),
+           (unsigned long long)(record->timing.phase_ns[PHASE_RUN] / NS_IN_US),
+           (unsigned long long)(record->timing.phase_ns[PHASE_TEAR_DOWN] / NS_IN_US));
+}
+
+void timing_print_summary(void)
+{
+    if (num_records == 0) {
+        return;
+    }
+
+    qsort(records, num_records, sizeof(timing_record_t), slowest_first);
+
+    printf("Slowest tests:\n");
+    for (int i = 0; i < MIN(num_records, NUM_SLOWEST_TESTS); i++) {
+        print_record(&records[i]);
+    }
+
+    int over_budget = 0;
+    while (over_budget < num_records && timing_total(&records[over_budget].timing) > TEST_TIME_BUDGET_NS) {
+        over_budget++;
+    }
+    printf("%d of %d tests took longer than %llu ms\n", over_budget, num_records,
+           (unsigned long long)(TEST_TIME_BUDGET_NS / NS_IN_MS));
+    /* the slowest tests are listed already */
+    for (int i = NUM_SLOWEST_TESTS; i < over_budget; i++) {
+        print_record(&records[i]);
+    }
+
+    free(records);
+    records = NULL;
+    num_records = 0;
+    max_records = 0;
+}
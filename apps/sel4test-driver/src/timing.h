@@ -0,0 +1,56 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <utils/time.h>
+
+/* Tests should not take longer than this each (see docs/design.md) */
+#define TEST_TIME_BUDGET_NS (10 * NS_IN_MS)
+
+/* Number of the slowest tests to list at the end of the run */
+#define NUM_SLOWEST_TESTS 10
+
+typedef enum {
+    PHASE_SET_UP,
+    PHASE_RUN,
+    PHASE_TEAR_DOWN,
+    NUM_TEST_PHASES,
+} test_phase_t;
+
+/* How long each phase of a test took */
+typedef struct test_timing {
+    /* the test was timed, there is no timing without a timer */
+    bool timed;
+    uint64_t phase_ns[NUM_TEST_PHASES];
+    /* end of the last phase timed */
+    uint64_t mark;
+} test_timing_t;
+
+struct driver_env;
+
+/* Start timing the phases of a test */
+void timing_start(struct driver_env *env, test_timing_t *timing);
+
+/* Start timing the next phase, without counting the time since the last one */
+void timing_restart(struct driver_env *env, test_timing_t *timing);
+
+/* Add the time since the end of the last phase to a phase */
+void timing_end_phase(struct driver_env *env, test_timing_t *timing, test_phase_t phase);
+
+uint64_t timing_total(test_timing_t *timing);
+
+/* Make room to keep the timing of num_tests tests, more room is made if
+ * more are recorded */
+void timing_init(int num_tests);
+
+/* Keep the timing of a test for the summary */
+void timing_record(const char *name, test_timing_t *timing);
+
+/* Print the slowest tests, and the tests over budget */
+void timing_print_summary(void);
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <stdio.h>
+
+#include <utils/util.h>
+
+#include "usage.h"
+
+/* read-only pages of the test image, for CONFIG_DEMAND_PAGING */
+static int usage_image_pages;
+
+void usage_set_image_pages(int pages)
+{
+    usage_image_pages = pages;
+}
+
+static const char *object_type_name(int type)
+{
+    switch (type) {
+    case seL4_UntypedObject:
+        return "untyped";
+    case seL4_TCBObject:
+        return "tcb";
+    case seL4_EndpointObject:
+        return "endpoint";
+    case seL4_NotificationObject:
+        return "notification";
+    case seL4_CapTableObject:
+        return "cnode";
+#ifdef CONFIG_KERNEL_MCS
+    case seL4_SchedContextObject:
+        return "sched_context";
+    case seL4_ReplyObject:
+        return "reply";
+#endif
+    default:
+        /* the rest are architecture specific, mostly frames and paging structures */
+        return NULL;
+    }
+}
+
+static bool close_to_limit(seL4_Word used, seL4_Word limit)
+{
+    return limit > 0 && used * 100 > limit * USAGE_WARN_PERCENT;
+}
+
+void usage_print(const char *name, test_usage_t *usage, bool xml)
+{
+    seL4_Word retyped = 0;
+    for (int i = 0; i < seL4_ObjectTypeCount; i++) {
+        retyped += usage->retyped_bytes[i];
+    }
+    seL4_Word slots = usage->peak_slots;
+    seL4_Word max_slots = usage->max_slots;
+
+    if (xml) {
+        printf("\t\t\t<property name=\"retyped_bytes\" value=\"%lu\"/>\n", (unsigned long) retyped);
+        printf("\t\t\t<property name=\"untyped_refills\" value=\"%lu\"/>\n",
+               (unsigned long) usage->untyped_refills);
+        printf("\t\t\t<property name=\"peak_slots\" value=\"%lu\"/>\n", (unsigned long) slots);
+        printf("\t\t\t<property name=\"heap_bytes\" value=\"%lu\"/>\n", (unsigned long) usage->heap_bytes);
+        printf("\t\t\t<property name=\"stack_bytes\" value=\"%lu\"/>\n", (unsigned long) usage->stack_bytes);
+        if (config_set(CONFIG_DEMAND_PAGING)) {
+            printf("\t\t\t<property name=\"paged_in\" value=\"%lu\"/>\n", (unsigned long) usage->paged_in);
+        }
+        return;
+    }
+
+    printf("%s used: retyped %lu/%lu KiB (", name, (unsigned long)(retyped / 1024),
+           (unsigned long)(usage->untyped_bytes / 1024));
+    const char *separator = "";
+    for (int i = 0; i < seL4_ObjectTypeCount; i++) {
+        if (usage->retyped_bytes[i] == 0) {
+            continue;
+        }
+        const char *type = object_type_name(i);
+        if (type != NULL) {
+            printf("%s%s %lu", separator, type, (unsigned long)(usage->retyped_bytes[i] / 1024));
+        } else {
+            printf("%stype %d %lu", separator, i, (unsigned long)(usage->retyped_bytes[i] / 1024));
+        }
+        separator = ", ";
+    }
+    printf("), %lu untyped refills, slots %lu/%lu, heap %lu/%lu KiB, stack %lu/%lu KiB\n",
+           (unsigned long) usage->untyped_refills, (unsigned long) slots, (unsigned long) max_slots,
+           (unsigned long)(usage->heap_bytes / 1024), (unsigned long)(usage->heap_size / 1024),
+           (unsigned long)(usage->stack_bytes / 1024), (unsigned long)(CONFIG_SEL4UTILS_STACK_SIZE / 1024));
+    if (config_set(CONFIG_DEMAND_PAGING)) {
+        printf("%s paged in %lu of %d read-only image pages\n", name, (unsigned long) usage->paged_in,
+               usage_image_pages);
+    }
+
+    if (close_to_limit(retyped, usage->untyped_bytes)) {
+        printf("%s is close to running out of untyped memory\n", name);
+    }
+    if (close_to_limit(slots, max_slots)) {
+        printf("%s is close to running out of cspace slots\n", name);
+    }
+    if (close_to_limit(usage->heap_bytes, usage->heap_size)) {
+        printf("%s is close to running out of heap\n", name);
+    }
+    if (close_to_limit(usage->stack_bytes, CONFIG_SEL4UTILS_STACK_SIZE)) {
+        printf("%s is close to running out of stack\n", name);
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include <test_init_data.h>
+
+/* Tests using more than this percentage of a resource are flagged */
+#define USAGE_WARN_PERCENT 90
+
+/* Print the resources a test used (CONFIG_REPORT_RESOURCES), as a line of
+ * text or as property elements for the properties of its JUnit testcase. */
+void usage_print(const char *name, test_usage_t *usage, bool xml);
+
+/* Set the number of pages that tests can page in (CONFIG_DEMAND_PAGING) */
+void usage_set_image_pages(int pages);
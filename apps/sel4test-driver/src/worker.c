@@ -0,0 +1,145 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Include Kconfig variables. */
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
+
+#include <sel4utils/thread.h>
+#include <sel4utils/thread_config.h>
+#include <sync/mutex.h>
+#include <vka/object.h>
+#include <utils/util.h>
+
+#include "worker.h"
+
+#define MAX_WORKER_JOBS 4
+
+/* the worker runs on this core when there is more than one */
+#define WORKER_CORE 1
+
+static sel4utils_thread_t worker_thread;
+static vka_object_t worker_notification;
+static sync_mutex_t driver_mutex;
+static bool worker_running;
+
+static worker_job_fn worker_jobs[MAX_WORKER_JOBS];
+static int num_worker_jobs;
+
+static void worker_main(void *arg0, UNUSED void *arg1, UNUSED void *ipc_buf)
+{
+    driver_env_t env = arg0;
+
+    while (1) {
+        seL4_Wait(worker_notification.cptr, NULL);
+
+        bool progress;
+        do {
+            progress = false;
+            for (int i = 0; i < num_worker_jobs; i++) {
+                progress |= worker_jobs[i](env);
+            }
+        } while (progress);
+    }
+}
+
+static void set_worker_affinity(driver_env_t env)
+{
+    if (simple_get_core_count(&env->simple) <= WORKER_CORE) {
+        return;
+    }
+
+#ifdef CONFIG_KERNEL_MCS
+    seL4_Time timeslice = CONFIG_BOOT_THREAD_TIME_SLICE * US_IN_S;
+    int error = seL4_SchedControl_Configure(simple_get_sched_ctrl(&env->simple, WORKER_CORE),
+                                            worker_thread.sched_context.cptr,
+                                            timeslice, timeslice, 0, 0);
+    ZF_LOGF_IF(error, "Failed to configure worker scheduling context");
+#elif CONFIG_MAX_NUM_NODES > 1
+    int error = seL4_TCB_SetAffinity(worker_thread.tcb.cptr, WORKER_CORE);
+    ZF_LOGF_IF(error, "Failed to set worker affinity");
+#endif
+}
+
+void worker_init(driver_env_t env)
+{
+    if (worker_running) {
+        return;
+    }
+
+    int error = sync_mutex_new(&env->vka, &driver_mutex);
+    ZF_LOGF_IF(error, "Failed to create driver lock");
+    error = sync_mutex_lock(&driver_mutex);
+    ZF_LOGF_IF(error, "Failed to take driver lock");
+
+    error = vka_alloc_notification(&env->vka, &worker_notification);
+    ZF_LOGF_IF(error, "Failed to allocate worker notification");
+
+    /* On a uniprocessor the worker only gets to run while the main thread and
+     * the test are both blocked, so it must sit below the test's priority. */
+    seL4_Word data = api_make_guard_skip_word(seL4_WordBits - simple_get_cnode_size_bits(&env->simple));
+    sel4utils_thread_config_t config = thread_config_default(&env->simple, simple_get_cnode(&env->simple), data,
+                                                             seL4_CapNull, env->init->priority - 1);
+    error = sel4utils_configure_thread_config(&env->vka, &env->vspace, &env->vspace, config, &worker_thread);
+    ZF_LOGF_IF(error, "Failed to configure worker thread");
+    set_worker_affinity(env);
+#ifdef CONFIG_DEBUG_BUILD
+    seL4_DebugNameThread(worker_thread.tcb.cptr, "sel4test-worker");
+#endif
+
+    error = sel4utils_start_thread(&worker_thread, worker_main, env, NULL, 1);
+    ZF_LOGF_IF(error, "Failed to start worker thread");
+
+    worker_running = true;
+}
+
+void worker_add_job(worker_job_fn job)
+{
+    ZF_LOGF_IF(num_worker_jobs == MAX_WORKER_JOBS, "Too many worker jobs");
+    worker_jobs[num_worker_jobs++] = job;
+}
+
+void worker_wake(driver_env_t env)
+{
+    if (worker_running) {
+        seL4_Signal(worker_notification.cptr);
+    }
+}
+
+void driver_lock(driver_env_t env)
+{
+    if (worker_running) {
+        int error = sync_mutex_lock(&driver_mutex);
+        ZF_LOGF_IF(error, "Failed to take driver lock");
+    }
+}
+
+void driver_unlock(driver_env_t env)
+{
+    if (worker_running) {
+        int error = sync_mutex_unlock(&driver_mutex);
+        ZF_LOGF_IF(error, "Failed to release driver lock");
+    }
+}
+
+void driver_lock_after_recv(driver_env_t env, seL4_MessageInfo_t info)
+{
+    if (!worker_running) {
+        return;
+    }
+
+    seL4_Word length = seL4_MessageInfo_get_length(info);
+    seL4_Word mrs[seL4_MsgMaxLength];
+    for (seL4_Word i = 0; i < length; i++) {
+        mrs[i] = seL4_GetMR(i);
+    }
+
+    driver_lock(env);
+
+    for (seL4_Word i = 0; i < length; i++) {
+        seL4_SetMR(i, mrs[i]);
+    }
+}
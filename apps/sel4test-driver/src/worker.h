@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026, UNSW
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <sel4/sel4.h>
+#include "test.h"
+
+/* The driver can hand work that isn't on the critical path of a test, such as
+ * building the next test process, to a background worker thread.
+ *
+ * The driver's allocators, vspace and heap are not thread safe, so both
+ * threads share a single lock. The main thread holds it at all times except
+ * while it is blocked waiting for the running test. Background jobs must
+ * take it around anything that touches driver state. */
+
+/* A piece of background work. Returns true if it did something, in which case
+ * all the jobs are run again before the worker goes back to sleep. */
+typedef bool (*worker_job_fn)(driver_env_t env);
+
+/* Start the worker thread. Safe to call more than once. The main thread
+ * holds the driver lock on return. */
+void worker_init(driver_env_t env);
+
+/* Register a job to be run by the worker */
+void worker_add_job(worker_job_fn job);
+
+/* Ask the worker to run its jobs */
+void worker_wake(driver_env_t env);
+
+/* Take and release the driver lock. These do nothing until the worker has
+ * been started. */
+void driver_lock(driver_env_t env);
+void driver_unlock(driver_env_t env);
+
+/* Take the driver lock after receiving a message of the given length.
+ * Waiting for the lock clobbers the message registers, so they are saved
+ * and restored around it. */
+void driver_lock_after_recv(driver_env_t env, seL4_MessageInfo_t info);
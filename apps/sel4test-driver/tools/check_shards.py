@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026, UNSW
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+
+"""
+Check that the logs of a sharded sel4test run cover every test once.
+
+Each shard prints "Shard <index>/<count>: <run> of <selected> tests" before
+its tests. The logs must be from the same image and run configuration, come
+from every shard, pass, and between them run each selected test exactly once.
+"""
+
+import argparse
+import re
+import sys
+
+SHARD_RE = re.compile(r'^Shard (\d+)/(\d+): (\d+) of (\d+) tests$', re.MULTILINE)
+TEST_RE = re.compile(r'^(?:Starting test \d+: |\t<testcase classname="sel4test" name=")([^"\n]+)', re.MULTILINE)
+PASSED = 'All is well in the universe'
+
+# tests of the driver itself, that every shard runs
+DRIVER_TESTS = {'Test that there are tests', 'Test all tests ran'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('logs', nargs='+', help='serial logs of the shards')
+    args = parser.parse_args()
+
+    errors = []
+    shards = {}
+    selected = None
+    count = None
+    owner = {}
+    for log in args.logs:
+        with open(log, errors='replace') as f:
+            text = f.read()
+        match = SHARD_RE.search(text)
+        if match is None:
+            errors.append('%s: not the log of a shard' % log)
+            continue
+        index, shard_count, run, shard_selected = (int(g) for g in match.groups())
+        if count is None:
+            count, selected = shard_count, shard_selected
+        elif (count, selected) != (shard_count, shard_selected):
+            errors.append('%s: shard of %d of %d tests, expected %d of %d tests' %
+                          (log, shard_count, shard_selected, count, selected))
+            continue
+        if index in shards:
+            errors.append('%s: shard %d is also in %s' % (log, index, shards[index]))
+            continue
+        shards[index] = log
+
+        if PASSED not in text:
+            errors.append('%s: shard %d did not pass' % (log, index))
+        names = set(TEST_RE.findall(text[match.end():])) - DRIVER_TESTS
+        if len(names) != run:
+            errors.append('%s: shard %d ran %d tests, expected %d' % (log, index, len(names), run))
+        for name in names:
+            if name in owner:
+                errors.append('%s: %s also ran in %s' % (log, name, owner[name]))
+            owner[name] = log
+
+    if count is not None:
+        missing = sorted(set(range(count)) - set(shards))
+        if missing:
+            errors.append('missing shards: %s' % ', '.join(str(i) for i in missing))
+        if len(owner) != selected:
+            errors.append('%d of %d tests ran' % (len(owner), selected))
+
+    for error in errors:
+        print(error, file=sys.stderr)
+    if errors:
+        return 1
+    print('%d shards ran all %d tests' % (count, selected))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
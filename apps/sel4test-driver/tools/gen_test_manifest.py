@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026, UNSW
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+
+"""
+Write a JSON manifest of the tests in the sel4test-driver and sel4test-tests
+images, without booting them. Tests that do not match the test regex are
+compiled out of the images (see include/test_select.h), so they are not listed.
+
+The tests are read from the _test_case section of each image, and their types
+from the _test_type section of the driver, the same way the driver finds them
+at boot. Deadlines and flaky markings are taken from the _test_deadline and
+_test_flaky sections of the tests image. The source file of each test is found
+by scanning the sources given, as gen_test_registry.py does.
+
+The manifest is a list of tests, in the order of the registry:
+
+  [{"name": "CNODEOP0001", "description": "Basic seL4_CNode_Copy() testing",
+    "type": "BASIC", "enabled": true, "image": "sel4test-tests",
+    "source": "src/tests/cnodeops.c", "deadline_ms": 0, "flaky_retries": 0},
+   ...]
+
+The layouts of the sections follow libsel4test's testcase_t and struct
+test_type, and test_init_data.h, for the word size of the image.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+from gen_test_registry import COMMENT_RE, find_tests, find_wrappers
+
+SHT_NOBITS = 8
+
+
+class Elf:
+    """Just enough of an ELF file to read the contents of its sections"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            sys.exit('%s is not an ELF file' % path)
+        self.path = path
+        self.word = 8 if self.data[4] == 2 else 4
+        self.endian = '<' if self.data[5] == 1 else '>'
+        self.word_fmt = 'Q' if self.word == 8 else 'I'
+
+        if self.word == 8:
+            shoff, = self.unpack('Q', 0x28)
+            shentsize, shnum, shstrndx = self.unpack('HHH', 0x3a)
+            header = 'IIQQQQIIQQ'
+        else:
+            shoff, = self.unpack('I', 0x20)
+            shentsize, shnum, shstrndx = self.unpack('HHH', 0x2e)
+            header = 'IIIIIIIIII'
+
+        sections = []
+        for i in range(shnum):
+            name, sh_type, _, addr, offset, size = self.unpack(header, shoff + i * shentsize)[:6]
+            sections.append((name, sh_type, addr, offset, size))
+        strtab = sections[shstrndx][3]
+        self.sections = {}
+        for name, sh_type, addr, offset, size in sections:
+            end = self.data.index(b'\0', strtab + name)
+            self.sections[self.data[strtab + name:end].decode()] = (sh_type, addr, offset, size)
+
+    def unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def section(self, name):
+        """Contents of a section, or None if the image does not have it"""
+        if name not in self.sections:
+            return None
+        _, _, offset, size = self.sections[name]
+        return self.data[offset:offset + size]
+
+    def string(self, vaddr):
+        """String at a virtual address of the image"""
+        if vaddr == 0:
+            return None
+        for sh_type, addr, offset, size in self.sections.values():
+            if sh_type != SHT_NOBITS and addr != 0 and addr <= vaddr < addr + size:
+                start = offset + vaddr - addr
+                return self.data[start:self.data.index(b'\0', start)].decode(errors='replace')
+        return None
+
+    def test_name_max(self):
+        """TEST_NAME_MAX of libsel4test, so that a testcase_t is 64 bytes"""
+        return 64 - 4 * self.word
+
+
+def c_string(data):
+    return data.split(b'\0', 1)[0].decode(errors='replace')
+
+
+def read_testcases(elf):
+    """Tests of the _test_case section: char name[TEST_NAME_MAX], then the
+    description, function, test type and enabled flag, a word each"""
+    data = elf.section('_test_case') or b''
+    name_max = elf.test_name_max()
+    size = name_max + 4 * elf.word
+    if len(data) % size != 0:
+        sys.exit('%s: _test_case is not a whole number of tests' % elf.path)
+    tests = []
+    for offset in range(0, len(data), size):
+        description, _, test_type, enabled = struct.unpack_from(elf.endian + 4 * elf.word_fmt, data,
+                                                                offset + name_max)
+        tests.append({
+            'name': c_string(data[offset:offset + name_max]),
+            'description': elf.string(description),
+            'type': test_type,
+            'enabled': enabled != 0,
+            'image': os.path.basename(elf.path),
+        })
+    return tests
+
+
+def read_test_types(elf):
+    """Names of the test types of the _test_type section, by id: the name,
+    then the id, then the functions of the type, a word each"""
+    data = elf.section('_test_type') or b''
+    size = 7 * elf.word
+    types = {}
+    for offset in range(0, len(data) - size + 1, size):
+        name, = struct.unpack_from(elf.endian + elf.word_fmt, data, offset)
+        test_type, = struct.unpack_from(elf.endian + 'i', data, offset + elf.word)
+        types[test_type] = elf.string(name)
+    return types
+
+
+def read_named_values(elf, section):
+    """Values of a section of test_deadline_t or test_flaky_t, by test name"""
+    data = elf.section(section) or b''
+    name_max = elf.test_name_max()
+    values = {}
+    for offset in range(0, len(data) - name_max - 8 + 1, name_max + 8):
+        value, = struct.unpack_from(elf.endian + 'Q', data, offset + name_max)
+        values[c_string(data[offset:offset + name_max])] = value
+    return values
+
+
+def find_sources(sources, search_dirs):
+    """Source file that defines each test"""
+    texts = {}
+    for source in sources:
+        if not source.endswith(('.c', '.h', '.cxx')):
+            continue
+        path = source
+        for directory in search_dirs:
+            if not os.path.isabs(path) and os.path.exists(os.path.join(directory, source)):
+                path = os.path.join(directory, source)
+        with open(path) as f:
+            texts[source] = COMMENT_RE.sub('', f.read())
+
+    wrappers = find_wrappers(texts.values())
+    defined = {}
+    for source, text in texts.items():
+        for name in find_tests([text], wrappers):
+            defined[name] = source
+    return defined
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--driver', required=True, help='sel4test-driver image')
+    parser.add_argument('--tests', required=True, help='sel4test-tests image')
+    parser.add_argument('--output', required=True, help='manifest to write')
+    parser.add_argument('--search-dir', action='append', default=[],
+                        help='directory to resolve relative source paths in')
+    parser.add_argument('sources', nargs='*', help='sources to find the tests in')
+    args = parser.parse_args()
+
+    driver = Elf(args.driver)
+    tests = Elf(args.tests)
+    types = read_test_types(driver)
+    deadlines = read_named_values(tests, '_test_deadline')
+    flaky = read_named_values(tests, '_test_flaky')
+    sources = find_sources(args.sources, args.search_dir)
+
+    manifest = read_testcases(driver) + read_testcases(tests)
+    for test in manifest:
+        test['type'] = types.get(test['type'], str(test['type']))
+        test['source'] = sources.get(test['name'])
+        test['deadline_ms'] = deadlines.get(test['name'], 0)
+        test['flaky_retries'] = flaky.get(test['name'], 0)
+    manifest.sort(key=lambda test: test['name'])
+
+    with open(args.output, 'w') as f:
+        json.dump(manifest, f, indent=1)
+        f.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+#
+# Copyright 2026, UNSW
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+
+"""
+Generate the test registry of sel4test.
+
+The sources of the driver and the tests images are scanned for the tests they
+define. The tests whose names match the test regex are sorted into the order
+they run in, and a perfect hash from name to position in that order is built,
+so that the driver does not have to filter and sort the tests when it boots.
+The tests that do not match are listed in a second header, which compiles them
+out of both images (see include/test_select.h).
+
+Tests are found as the first argument of DEFINE_TEST and its variants, or of
+any macro whose body passes its first parameter on to one of them.
+
+The serial logs of earlier runs, text or XML, can be given with --cost-log to
+build the cost table the driver orders tests by (see Sel4testTestOrder): the
+longest time each test took in any of the logs, and whether it failed in any
+of them. Tests that are in none of the logs cost the mean of the others.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+HASH_BASIS = 0x811c9dc5
+HASH_PRIME = 0x01000193
+HASH_MASK = 0xffffffff
+
+DEFINE_RE = re.compile(r'^[ \t]*#[ \t]*define[ \t]+(\w+)\(([^)]*)\)((?:.*\\\n)*.*)', re.MULTILINE)
+COMMENT_RE = re.compile(r'/\*.*?\*/|//[^\n]*', re.DOTALL)
+
+# lines of a log that give the cost of a test, or say that it failed
+TOOK_RE = re.compile(r'^(\S+) took (\d+) us ')
+TESTCASE_RE = re.compile(r'^\t<testcase classname="sel4test" name="([^"]+)"(?: time="(\d+)\.(\d+)")?')
+STARTING_RE = re.compile(r'^Starting test \d+: (\S+)$')
+FAILED_RE = re.compile(r'^\s*(Error: |<failure|<error)')
+CRASHED_RE = re.compile(r'^CRASHED: test \d+ (\S+): ')
+
+
+def test_hash(name, seed):
+    """FNV-1a, with the seed mixed into the basis. Must match the driver."""
+    h = (HASH_BASIS ^ seed) & HASH_MASK
+    for c in name.encode():
+        h = ((h ^ c) * HASH_PRIME) & HASH_MASK
+    return h
+
+
+def find_wrappers(sources):
+    """Names of the macros that define a test named by their first parameter."""
+    wrappers = {'DEFINE_TEST', 'DEFINE_TEST_BOOTSTRAP', 'DEFINE_TEST_PERSISTENT'}
+    defines = []
+    for text in sources:
+        for match in DEFINE_RE.finditer(text):
+            params = [p.strip() for p in match.group(2).split(',')]
+            defines.append((match.group(1), params[0], match.group(3)))
+
+    changed = True
+    while changed:
+        changed = False
+        for name, first, body in defines:
+            if name in wrappers or not first:
+                continue
+            for wrapper in wrappers:
+                if re.search(r'\b%s\(\s*%s\s*,' % (wrapper, re.escape(first)), body):
+                    wrappers.add(name)
+                    changed = True
+                    break
+    return wrappers
+
+
+def find_tests(sources, wrappers):
+    """Names of all the tests defined in the sources, outside of macros."""
+    use_re = re.compile(r'\b(%s)\(\s*(\w+)\s*,' % '|'.join(sorted(wrappers)))
+    tests = set()
+    for text in sources:
+        text = DEFINE_RE.sub('', text)
+        for match in use_re.finditer(text):
+            tests.add(match.group(2))
+    return tests
+
+
+def perfect_hash(names):
+    """Hash and displace: each bucket of names gets the seed that puts all of
+    its names in free slots. Returns the seed of each bucket and the index of
+    the name in each slot."""
+    num_buckets = max(1, (len(names) + 3) // 4)
+    num_slots = 1
+    while num_slots < 2 * len(names):
+        num_slots *= 2
+    num_slots = max(num_slots, 2)
+
+    buckets = [[] for _ in range(num_buckets)]
+    for index, name in enumerate(names):
+        buckets[test_hash(name, 0) % num_buckets].append(index)
+
+    seeds = [0] * num_buckets
+    slots = [-1] * num_slots
+    for bucket in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            continue
+        seed = 1
+        while True:
+            wanted = [test_hash(names[i], seed) % num_slots for i in buckets[bucket]]
+            if len(set(wanted)) == len(wanted) and all(slots[s] < 0 for s in wanted):
+                break
+            seed += 1
+        seeds[bucket] = seed
+        for index, slot in zip(buckets[bucket], wanted):
+            slots[slot] = index
+    return seeds, slots
+
+
+def read_costs(logs):
+    """Longest time in us each test took in the logs, and the tests that
+    failed in any of them."""
+    costs = {}
+    failed = set()
+    for log in logs:
+        current = None
+        with open(log, errors='replace') as f:
+            for line in f:
+                line = line.rstrip('\r\n')
+                match = STARTING_RE.match(line)
+                if match:
+                    current = match.group(1)
+                match = TESTCASE_RE.match(line)
+                if match:
+                    current = match.group(1)
+                    if match.group(2) is not None:
+                        us = int(match.group(2)) * 1000000 + int(match.group(3).ljust(6, '0')[:6])
+                        costs[current] = max(costs.get(current, 0), us)
+                if line == '\t</testcase>':
+                    # what the next test prints comes before its element
+                    current = None
+                match = TOOK_RE.match(line)
+                if match:
+                    costs[match.group(1)] = max(costs.get(match.group(1), 0), int(match.group(2)))
+                match = CRASHED_RE.match(line)
+                if match:
+                    failed.add(match.group(1))
+                elif current is not None and FAILED_RE.match(line):
+                    failed.add(current)
+    return costs, failed
+
+
+def c_array(values, per_line):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ' '.join('%s,' % v for v in values[i:i + per_line]))
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--regex', required=True, help='regex of the tests to run')
+    parser.add_argument('--output', required=True, help='header to generate')
+    parser.add_argument('--unselected-output', required=True,
+                        help='header to generate with the tests that do not match')
+    parser.add_argument('--search-dir', action='append', default=[],
+                        help='directory to resolve relative source paths in')
+    parser.add_argument('--cost-log', action='append', default=[],
+                        help='serial log of an earlier run to take the cost of tests from')
+    parser.add_argument('sources', nargs='*', help='sources to scan for tests')
+    args = parser.parse_args()
+
+    texts = []
+    for source in args.sources:
+        if not source.endswith(('.c', '.h', '.cxx')):
+            continue
+        path = source
+        for directory in args.search_dir:
+            if not os.path.isabs(path) and os.path.exists(os.path.join(directory, source)):
+                path = os.path.join(directory, source)
+        with open(path) as f:
+            texts.append(COMMENT_RE.sub('', f.read()))
+
+    regex = re.compile(args.regex)
+    found = find_tests(texts, find_wrappers(texts))
+    names = sorted(t for t in found if regex.search(t))
+    seeds, slots = perfect_hash(names)
+
+    costs, failed = read_costs(args.cost_log)
+    known = [costs[n] for n in names if n in costs]
+    mean = sum(known) // len(known) if known else 0
+    cost_us = [min(costs.get(n, mean), 0xffffffff) for n in names]
+    recently_failed = [int(n in failed) for n in names]
+
+    with open(args.output, 'w') as out:
+        out.write('''/* Auto-generated by %s. Do not edit manually. */
+#pragma once
+
+#include <stdint.h>
+
+/* tests matching "%s", in the order they run */
+#define TEST_REGISTRY_SIZE %d
+static const char *const test_registry_names[TEST_REGISTRY_SIZE + 1] = {
+%s
+    NULL,
+};
+
+/* perfect hash from test name to registry index */
+#define TEST_REGISTRY_BUCKETS %d
+#define TEST_REGISTRY_SLOTS %d
+static const uint32_t test_registry_seeds[TEST_REGISTRY_BUCKETS] = {
+%s
+};
+static const int16_t test_registry_slots[TEST_REGISTRY_SLOTS] = {
+%s
+};
+
+/* cost table from %d logs, that has the time of %d of the tests */
+#define TEST_REGISTRY_COSTS_KNOWN %d
+/* time each test took in us */
+static const uint32_t test_registry_cost_us[TEST_REGISTRY_SIZE + 1] = {
+%s
+    0,
+};
+/* whether each test failed */
+static const uint8_t test_registry_failed[TEST_REGISTRY_SIZE + 1] = {
+%s
+    0,
+};
+''' % (os.path.basename(sys.argv[0]), args.regex.replace('\\', '\\\\').replace('"', '\\"'), len(names),
+            '\n'.join('    "%s",' % n for n in names), len(seeds), len(slots),
+            c_array(seeds, 8), c_array(slots, 16), len(args.cost_log), len(known), len(known),
+            c_array(cost_us, 8), c_array(recently_failed, 16)))
+
+    # every source of the tests includes this header, so only touch it when
+    # the selection changes
+    unselected = '/* Auto-generated by %s. Do not edit manually. */\n#pragma once\n\n%s' % (
+        os.path.basename(sys.argv[0]),
+        ''.join('#define TEST_UNSELECTED_%s 1\n' % t for t in sorted(found - set(names))))
+    try:
+        with open(args.unselected_output) as f:
+            unchanged = f.read() == unselected
+    except OSError:
+        unchanged = False
+    if not unchanged:
+        with open(args.unselected_output, 'w') as out:
+            out.write(unselected)
+
+
+if __name__ == '__main__':
+    main()
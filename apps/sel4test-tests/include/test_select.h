@@ -0,0 +1 @@
+../../sel4test-driver/include/test_select.h
\ No newline at end of file
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
 #include <sel4/sel4.h>
 #include <sel4utils/arch/util.h>
 #include <sel4utils/helpers.h>
@@ -194,6 +196,11 @@ void create_helper_process_custom_asid(env_t env, helper_thread_t *thread, seL4_
 
     thread->is_process = true;
 
+    /* the regions are cloned from our vspace, so have them all mapped here
+     * first. A fault of the helper is then never mistaken for one that the
+     * driver pages in. */
+    page_in_image(env);
+
     sel4utils_process_config_t config = process_config_default_simple(&env->simple, "", OUR_PRIO - 1);
     config = process_config_asid_pool(config, asid);
     config = process_config_noelf(config, NULL, 0);
@@ -331,6 +338,27 @@ void cleanup_helper(env_t env, helper_thread_t *thread)
     }
 }
 
+void page_in_image(env_t env)
+{
+    if (!config_set(CONFIG_DEMAND_PAGING)) {
+        return;
+    }
+
+    /* touch every page of the read-only regions, the driver maps each one
+     * in when this thread faults on it */
+    for (int i = 0; i < env->num_regions; i++) {
+        sel4utils_elf_region_t *region = &env->regions[i];
+        if (seL4_CapRights_get_capAllowWrite(region->rights)) {
+            continue;
+        }
+        uintptr_t start = ROUND_DOWN((uintptr_t) region->elf_vstart, PAGE_SIZE_4K);
+        uintptr_t end = (uintptr_t) region->elf_vstart + region->size;
+        for (uintptr_t page = start; page < end; page += PAGE_SIZE_4K) {
+            (void) *(volatile char *) page;
+        }
+    }
+}
+
 void create_helper_thread(env_t env, helper_thread_t *thread)
 {
     create_helper_thread_custom_stack(env, thread, BYTES_TO_4K_PAGES(CONFIG_SEL4UTILS_STACK_SIZE));
@@ -78,6 +78,12 @@ void set_helper_affinity(env_t env, helper_thread_t *thread, seL4_Word affinity)
 int set_helper_sched_params(UNUSED env_t env, UNUSED helper_thread_t *thread, UNUSED uint64_t budget,
                             UNUSED uint64_t period, seL4_Word badge);
 
+/* With CONFIG_DEMAND_PAGING, page in all of the read-only regions of the
+ * image. The driver only pages in for faults that it receives, so this must
+ * be called before giving a thread a fault handler other than the driver, or
+ * none, if that thread may run code or read data that is not paged in yet. */
+void page_in_image(env_t env);
+
 /* set a helper threads timeout fault handler */
 void set_helper_tfep(env_t env, helper_thread_t *thread, seL4_CPtr tfep);
 
@@ -5,9 +5,11 @@
  */
 
 #include <autoconf.h>
+#include <sel4test-driver/gen_config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <arch_stdio.h>
 #include <allocman/vka.h>
@@ -22,9 +24,13 @@
 #include <sel4utils/mapping.h>
 #include <sel4utils/vspace.h>
 
+#include <sel4rpc/client.h>
+#include <rpc.pb.h>
+
 #include <sel4test/test.h>
 
 #include <vka/capops.h>
+#include <vka/object.h>
 
 #include "helpers.h"
 #include "test.h"
@@ -34,6 +40,12 @@
 char _cpio_archive[1];
 char _cpio_archive_end[1];
 
+#if CONFIG_LIB_SEL4_MUSLC_SYS_MORECORE_BYTES > 0
+/* the heap of libsel4muslcsys */
+extern char morecore_area[];
+extern size_t morecore_size;
+#endif
+
 /* endpoint to call back to the test driver on */
 static seL4_CPtr endpoint;
 
@@ -60,9 +72,29 @@ void abort(void)
     while (1);
 }
 
+#ifdef CONFIG_PARALLEL_TESTS
+/* Output of BASIC tests, which run in parallel, is buffered for the driver to
+ * print when the test finishes. Copies of this process made by tests get their
+ * own copy of the buffer, so their output is lost. */
+static test_output_t output_buffer ALIGN(PAGE_SIZE_4K);
+static bool buffer_output;
+#endif /* CONFIG_PARALLEL_TESTS */
+
 void __plat_putchar(int c);
 static size_t write_buf(void *data, size_t count)
 {
+#ifdef CONFIG_PARALLEL_TESTS
+    if (buffer_output) {
+        size_t space = sizeof(output_buffer.data) - output_buffer.len;
+        if (count > space) {
+            output_buffer.truncated = true;
+        }
+        size_t len = MIN(count, space);
+        memcpy(&output_buffer.data[output_buffer.len], data, len);
+        output_buffer.len += len;
+        return count;
+    }
+#endif /* CONFIG_PARALLEL_TESTS */
     char *buf = data;
     for (int i = 0; i < count; i++) {
         __plat_putchar(buf[i]);
@@ -70,63 +102,196 @@ static size_t write_buf(void *data, size_t count)
     return count;
 }
 
-static testcase_t *find_test(const char *name)
+static testcase_t *find_test(const char *name, seL4_Word index)
 {
-    testcase_t *test = sel4test_get_test(name);
-    if (test == NULL) {
+    /* the driver tells us where our test is */
+    testcase_t *test = sel4test_get_test_by_index(index);
+    if (test == NULL || strcmp(test->name, name) != 0) {
         ZF_LOGF("Failed to find test %s", name);
     }
 
     return test;
 }
 
-static void init_allocator(env_t env, test_init_data_t *init_data)
+/* The untypeds are handed to the allocator one at a time, only when it fails
+ * to allocate with the ones it already has: first the seed untyped, then
+ * untypeds the driver hands out on request (see UNTYPED_REFILL_ADDRESS). The
+ * driver marks each untyped it hands out in the init data, so it only has to
+ * revoke the untypeds a test could have used. */
+static struct {
+    allocman_t *allocator;
+    test_init_data_t *init_data;
+    /* the vka before it was wrapped */
+    vka_t vka;
+    sel4rpc_client_t *rpc_client;
+    /* set once the seed has been given to the allocator */
+    bool seeded;
+    /* highest slot handed out by the allocator */
+    seL4_CPtr last_slot;
+} lazy_untypeds;
+
+static void add_untyped(seL4_Word cookie)
 {
-    UNUSED int error;
-    UNUSED reservation_t virtual_reservation;
+    cspacepath_t path;
+    vka_cspace_make_path(&lazy_untypeds.vka, lazy_untypeds.init_data->untypeds.start + UNTYPED_COOKIE_INDEX(cookie),
+                         &path);
+    /* allocman doesn't require the paddr unless we need to ask for phys addresses,
+     * which we don't. */
+    size_t size_bits = UNTYPED_COOKIE_SIZE_BITS(cookie);
+    int error = allocman_utspace_add_uts(lazy_untypeds.allocator, 1, &path, &size_bits, NULL,
+                                         ALLOCMAN_UT_KERNEL);
+    if (error) {
+        ZF_LOGF("Failed to add untyped objects to allocator");
+    }
+}
 
-    /* initialise allocator */
-    allocman_t *allocator = bootstrap_use_current_1level(init_data->root_cnode,
-                                                         init_data->cspace_size_bits, init_data->free_slots.start,
-                                                         init_data->free_slots.end, ALLOCATOR_STATIC_POOL_SIZE,
-                                                         allocator_mem_pool);
-    if (allocator == NULL) {
-        ZF_LOGF("Failed to bootstrap allocator");
+/* Give the allocator another untyped to allocate an object of type and
+ * size_bits from */
+static int add_next_untyped(seL4_Word type, seL4_Word size_bits)
+{
+    if (!lazy_untypeds.seeded) {
+        lazy_untypeds.seeded = true;
+        if (lazy_untypeds.init_data->untyped_seed != UNTYPED_COOKIE_NONE) {
+            add_untyped(lazy_untypeds.init_data->untyped_seed);
+            return 0;
+        }
     }
-    allocman_make_vka(&env->vka, allocator);
 
-    /* fill the allocator with untypeds */
-    seL4_CPtr slot;
-    unsigned int size_bits_index;
-    size_t size_bits;
-    cspacepath_t path;
-    for (slot = init_data->untypeds.start, size_bits_index = 0;
-         slot <= init_data->untypeds.end;
-         slot++, size_bits_index++) {
-
-        vka_cspace_make_path(&env->vka, slot, &path);
-        /* allocman doesn't require the paddr unless we need to ask for phys addresses,
-         * which we don't. */
-        size_bits = init_data->untyped_size_bits_list[size_bits_index];
-        error = allocman_utspace_add_uts(allocator, 1, &path, &size_bits, NULL,
-                                         ALLOCMAN_UT_KERNEL);
-        if (error) {
-            ZF_LOGF("Failed to add untyped objects to allocator");
+    RpcMessage rpcMsg = {
+        .which_msg = RpcMessage_memory_tag,
+        .msg.memory = {
+            .address = UNTYPED_REFILL_ADDRESS,
+            .size_bits = vka_get_object_size(type, size_bits),
+            .type = seL4_UntypedObject,
+        },
+    };
+    int error = sel4rpc_call(lazy_untypeds.rpc_client, &rpcMsg, seL4_CapNull, seL4_CapNull, 0);
+    if (error || rpcMsg.msg.ret.errorCode != 0) {
+        return -1;
+    }
+    add_untyped(rpcMsg.msg.ret.cookie);
+    return 0;
+}
+
+static void count_retyped(int error, seL4_Word type, seL4_Word size_bits)
+{
+    if (config_set(CONFIG_REPORT_RESOURCES) && !error && type < seL4_ObjectTypeCount) {
+        lazy_untypeds.init_data->usage.retyped_bytes[type] += BIT(vka_get_object_size(type, size_bits));
+    }
+}
+
+static int lazy_utspace_alloc(void *data, const cspacepath_t *dest, seL4_Word type, seL4_Word size_bits,
+                              seL4_Word *res)
+{
+    int error;
+    do {
+        error = lazy_untypeds.vka.utspace_alloc(data, dest, type, size_bits, res);
+    } while (error && add_next_untyped(type, size_bits) == 0);
+    count_retyped(error, type, size_bits);
+    return error;
+}
+
+static int lazy_utspace_alloc_maybe_device(void *data, const cspacepath_t *dest, seL4_Word type,
+                                           seL4_Word size_bits, bool can_use_dev, seL4_Word *res)
+{
+    int error;
+    do {
+        error = lazy_untypeds.vka.utspace_alloc_maybe_device(data, dest, type, size_bits, can_use_dev, res);
+    } while (error && add_next_untyped(type, size_bits) == 0);
+    count_retyped(error, type, size_bits);
+    return error;
+}
+
+/* Slots handed out are tracked so that a PERSISTENT test process can empty
+ * them before its next test. Caps made from the untypeds are deleted by the
+ * driver revoking them, but tests also copy caps they were given. */
+static int tracked_cspace_alloc(void *data, seL4_CPtr *res)
+{
+    int error = lazy_untypeds.vka.cspace_alloc(data, res);
+    if (!error) {
+        test_usage_t *usage = &lazy_untypeds.init_data->usage;
+        lazy_untypeds.last_slot = MAX(lazy_untypeds.last_slot, *res);
+        usage->slots++;
+        usage->peak_slots = MAX(usage->peak_slots, usage->slots);
+    }
+    return error;
+}
+
+static void tracked_cspace_free(void *data, seL4_CPtr slot)
+{
+    lazy_untypeds.vka.cspace_free(data, slot);
+    lazy_untypeds.init_data->usage.slots--;
+}
+
+/* The allocator as it was before it was given any untypeds, kept by a process
+ * that runs PERSISTENT tests so that each of its tests starts from it. The
+ * vspace cannot be kept the same way, as its bookkeeping and the pages of the
+ * allocator's virtual pool are made from the untypeds that the driver revokes
+ * between tests. */
+static struct {
+    char *mem_pool;
+    vka_t vka;
+    /* the slots below the free slots that held a cap */
+    seL4_Word *full_slots;
+} checkpoint;
+
+/* Whether a slot holds a cap. Moving a slot onto itself fails with
+ * seL4_DeleteFirst if it does, and with seL4_FailedLookup if it is empty. */
+static bool slot_is_full(test_init_data_t *init_data, seL4_CPtr slot)
+{
+    return seL4_CNode_Move(init_data->root_cnode, slot, init_data->cspace_size_bits, init_data->root_cnode, slot,
+                           init_data->cspace_size_bits) == seL4_DeleteFirst;
+}
+
+static void take_checkpoint(env_t env, test_init_data_t *init_data)
+{
+    checkpoint.mem_pool = malloc(ALLOCATOR_STATIC_POOL_SIZE);
+    seL4_Word words = (init_data->free_slots.start + seL4_WordBits - 1) / seL4_WordBits;
+    checkpoint.full_slots = calloc(words, sizeof(seL4_Word));
+    if (checkpoint.mem_pool == NULL || checkpoint.full_slots == NULL) {
+        ZF_LOGF("Failed to allocate allocator checkpoint");
+    }
+    memcpy(checkpoint.mem_pool, allocator_mem_pool, ALLOCATOR_STATIC_POOL_SIZE);
+    checkpoint.vka = env->vka;
+
+    for (seL4_CPtr slot = 0; slot < init_data->free_slots.start; slot++) {
+        if (slot_is_full(init_data, slot)) {
+            checkpoint.full_slots[slot / seL4_WordBits] |= BIT(slot % seL4_WordBits);
         }
     }
+}
 
-    /* add any arch specific objects to the allocator */
-    arch_init_allocator(env, init_data);
+/* Whether the last test left the slots below the free slots as they were.
+ * The caps in them were given to the process by the driver, and are not
+ * tracked by the allocator, so the next test cannot run here if they changed. */
+static bool cspace_unchanged(test_init_data_t *init_data)
+{
+    for (seL4_CPtr slot = 0; slot < init_data->free_slots.start; slot++) {
+        bool was_full = checkpoint.full_slots[slot / seL4_WordBits] & BIT(slot % seL4_WordBits);
+        if (slot_is_full(init_data, slot) != was_full) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void init_vspace(env_t env, test_init_data_t *init_data)
+{
+    UNUSED int error;
+    UNUSED reservation_t virtual_reservation;
 
     /* create a vspace */
-    void *existing_frames[init_data->stack_pages + 3];
-    existing_frames[0] = (void *) init_data;
-    existing_frames[1] = seL4_GetIPCBuffer();
+    void *existing_frames[TEST_INIT_DATA_PAGES + init_data->stack_pages + 2];
+    int num_frames = 0;
+    for (int i = 0; i < TEST_INIT_DATA_PAGES; i++) {
+        existing_frames[num_frames++] = (char *) init_data + (i * PAGE_SIZE_4K);
+    }
+    existing_frames[num_frames++] = seL4_GetIPCBuffer();
     assert(init_data->stack_pages > 0);
     for (int i = 0; i < init_data->stack_pages; i++) {
-        existing_frames[i + 2] = init_data->stack + (i * PAGE_SIZE_4K);
+        existing_frames[num_frames++] = init_data->stack + (i * PAGE_SIZE_4K);
     }
-    existing_frames[init_data->stack_pages + 2] = NULL;
+    existing_frames[num_frames] = NULL;
 
     error = sel4utils_bootstrap_vspace(&env->vspace, &alloc_data, init_data->page_directory, &env->vka,
                                        NULL, NULL, existing_frames);
@@ -139,11 +304,43 @@ static void init_allocator(env_t env, test_init_data_t *init_data)
         ZF_LOGF("Failed to switch allocator to virtual memory pool");
     }
 
-    bootstrap_configure_virtual_pool(allocator, vaddr, ALLOCATOR_VIRTUAL_POOL_SIZE,
+    bootstrap_configure_virtual_pool(lazy_untypeds.allocator, vaddr, ALLOCATOR_VIRTUAL_POOL_SIZE,
                                      env->page_directory);
 
 }
 
+static void init_allocator(env_t env, test_init_data_t *init_data, bool persistent)
+{
+    /* initialise allocator */
+    allocman_t *allocator = bootstrap_use_current_1level(init_data->root_cnode,
+                                                         init_data->cspace_size_bits, init_data->free_slots.start,
+                                                         init_data->free_slots.end, ALLOCATOR_STATIC_POOL_SIZE,
+                                                         allocator_mem_pool);
+    if (allocator == NULL) {
+        ZF_LOGF("Failed to bootstrap allocator");
+    }
+    allocman_make_vka(&env->vka, allocator);
+
+    /* untypeds are given to the allocator as it runs out of memory */
+    lazy_untypeds.allocator = allocator;
+    lazy_untypeds.init_data = init_data;
+    lazy_untypeds.vka = env->vka;
+    lazy_untypeds.rpc_client = &env->rpc_client;
+    lazy_untypeds.seeded = false;
+    env->vka.utspace_alloc = lazy_utspace_alloc;
+    env->vka.utspace_alloc_maybe_device = lazy_utspace_alloc_maybe_device;
+    env->vka.cspace_alloc = tracked_cspace_alloc;
+    env->vka.cspace_free = tracked_cspace_free;
+
+    /* add any arch specific objects to the allocator */
+    arch_init_allocator(env, init_data);
+
+    if (persistent) {
+        take_checkpoint(env, init_data);
+    }
+    init_vspace(env, init_data);
+}
+
 static uint8_t cnode_size_bits(void *data)
 {
     test_init_data_t *init = (test_init_data_t *) data;
@@ -160,6 +357,60 @@ static int core_count(UNUSED void *data)
     return ((test_init_data_t *) data)->cores;
 }
 
+/* Get ready for the next PERSISTENT test. The driver has revoked the untypeds,
+ * which deleted everything the last test made, so all that is left is to
+ * delete the caps it copied, go back to the allocator checkpoint and make a
+ * new vspace. */
+static void reset_for_next_test(env_t env, test_init_data_t *init_data)
+{
+    for (seL4_CPtr slot = init_data->free_slots.start; slot <= lazy_untypeds.last_slot; slot++) {
+        UNUSED int error = seL4_CNode_Delete(init_data->root_cnode, slot, init_data->cspace_size_bits);
+        assert(error == seL4_NoError);
+    }
+    lazy_untypeds.last_slot = 0;
+    init_data->usage.slots = 0;
+
+    memcpy(allocator_mem_pool, checkpoint.mem_pool, ALLOCATOR_STATIC_POOL_SIZE);
+    env->vka = checkpoint.vka;
+    lazy_untypeds.seeded = false;
+    init_vspace(env, init_data);
+}
+
+/* Start counting the resources used by the next test */
+static void start_usage(test_init_data_t *init_data)
+{
+    test_usage_t *usage = &init_data->usage;
+
+    memset(usage->retyped_bytes, 0, sizeof(usage->retyped_bytes));
+    usage->peak_slots = usage->slots;
+    usage->max_slots = init_data->free_slots.end - init_data->free_slots.start;
+}
+
+/* The stack and heap start out zeroed, so the high-water marks are where the
+ * first and last words that are not zero are. */
+static void end_usage(test_init_data_t *init_data)
+{
+    test_usage_t *usage = &init_data->usage;
+
+    seL4_Word *stack = init_data->stack;
+    seL4_Word stack_words = init_data->stack_pages * PAGE_SIZE_4K / sizeof(seL4_Word);
+    seL4_Word unused = 0;
+    while (unused < stack_words && stack[unused] == 0) {
+        unused++;
+    }
+    usage->stack_bytes = (stack_words - unused) * sizeof(seL4_Word);
+
+#if CONFIG_LIB_SEL4_MUSLC_SYS_MORECORE_BYTES > 0
+    seL4_Word *heap = (seL4_Word *) morecore_area;
+    seL4_Word heap_words = morecore_size / sizeof(seL4_Word);
+    while (heap_words > 0 && heap[heap_words - 1] == 0) {
+        heap_words--;
+    }
+    usage->heap_bytes = heap_words * sizeof(seL4_Word);
+    usage->heap_size = morecore_size;
+#endif
+}
+
 void init_simple(env_t env, test_init_data_t *init_data)
 {
     /* minimal simple implementation */
@@ -186,6 +437,9 @@ int main(int argc, char **argv)
 
     /* read in init data */
     init_data = (void *) atol(argv[1]);
+#ifdef CONFIG_PARALLEL_TESTS
+    init_data->output = &output_buffer;
+#endif
 
     /* configure env */
     env.cspace_root = init_data->root_cnode;
@@ -215,35 +469,62 @@ int main(int argc, char **argv)
 
     env.device_frame = init_data->device_frame_cap;
 
+    /* initialise rpc client, which the allocator asks for untypeds with */
+    sel4rpc_client_init(&env.rpc_client, env.endpoint, SEL4TEST_PROTOBUF_RPC);
+
     /* initialse cspace, vspace and untyped memory allocation */
-    init_allocator(&env, init_data);
+    testcase_t *test = find_test(init_data->name, init_data->test_index);
+    init_allocator(&env, init_data, test != NULL && test->test_type == PERSISTENT);
 
     /* initialise simple */
     init_simple(&env, init_data);
 
-    /* initialise rpc client */
-    sel4rpc_client_init(&env.rpc_client, env.endpoint, SEL4TEST_PROTOBUF_RPC);
+    /* run tests until one that needs the process to itself */
+    while (1) {
+#ifdef CONFIG_PARALLEL_TESTS
+        buffer_output = test != NULL && test->test_type == BASIC;
+#endif
+
+        /* run the test */
+        sel4test_reset();
+        if (config_set(CONFIG_REPORT_RESOURCES)) {
+            start_usage(init_data);
+        }
+        test_result_t result = SUCCESS;
+        if (test) {
+            printf("Running test %s (%s)\n", test->name, test->description);
+            result = test->function((uintptr_t)&env);
+        } else {
+            result = FAILURE;
+            ZF_LOGF("Cannot find test %s", init_data->name);
+        }
+        if (config_set(CONFIG_REPORT_RESOURCES)) {
+            end_usage(init_data);
+        }
 
-    /* find the test */
-    testcase_t *test = find_test(init_data->name);
+        printf("Test %s %s\n", init_data->name, result == SUCCESS ? "passed" : "failed");
+        if (test != NULL && test->test_type == PERSISTENT && !cspace_unchanged(init_data)) {
+            /* the driver gives the next test a new process */
+            printf("Test %s changed caps it did not allocate\n", init_data->name);
+            test = NULL;
+        }
+        if (test == NULL || test->test_type != PERSISTENT) {
+            /* send our result back */
+            seL4_MessageInfo_t info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
+            seL4_SetMR(0, result);
+            seL4_Send(endpoint, info);
+            break;
+        }
 
-    /* run the test */
-    sel4test_reset();
-    test_result_t result = SUCCESS;
-    if (test) {
-        printf("Running test %s (%s)\n", test->name, test->description);
-        result = test->function((uintptr_t)&env);
-    } else {
-        result = FAILURE;
-        ZF_LOGF("Cannot find test %s", init_data->name);
+        /* send our result back and wait for the next test */
+        seL4_MessageInfo_t info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 2);
+        seL4_SetMR(0, result);
+        seL4_SetMR(1, TEST_WAITING_FOR_NEXT);
+        seL4_Call(endpoint, info);
+        reset_for_next_test(&env, init_data);
+        test = find_test(init_data->name, init_data->test_index);
     }
 
-    printf("Test %s %s\n", init_data->name, result == SUCCESS ? "passed" : "failed");
-    /* send our result back */
-    seL4_MessageInfo_t info = seL4_MessageInfo_new(seL4_Fault_NullFault, 0, 0, 1);
-    seL4_SetMR(0, result);
-    seL4_Send(endpoint, info);
-
     /* It is expected that we are torn down by the test driver before we are
      * scheduled to run again after signalling them with the above send.
      */
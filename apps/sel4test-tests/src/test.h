@@ -17,8 +17,26 @@
 #include <simple/simple.h>
 #include <vspace/vspace.h>
 
-/* This file is a symlink to the original in sel4test-driver. */
+/* These files are symlinks to the originals in sel4test-driver. */
 #include <test_init_data.h>
+#include <test_select.h>
+
+/* Define a test that does not need a fresh process, see PERSISTENT */
+#define DEFINE_TEST_PERSISTENT(_name, _description, _function, _enabled) \
+    DEFINE_TEST_WITH_TYPE(_name, _description, _function, PERSISTENT, _enabled)
+
+/* Give a test a deadline, in ms, other than CONFIG_TEST_DEADLINE_MS. A
+ * deadline of 0 lets the test run for as long as it takes. */
+#define DEFINE_TEST_DEADLINE(_name, _ms) \
+    static test_deadline_t __attribute__((used)) __attribute__((section("_test_deadline"))) \
+    _name##_deadline = { .name = #_name, .ms = _ms }
+
+/* Mark a test as flaky: it is run up to _retries more times when it fails,
+ * and, if quarantining is turned on (CONFIG_QUARANTINE_FLAKY or the run
+ * config), is quarantined if every attempt fails. */
+#define DEFINE_TEST_FLAKY(_name, _retries) \
+    static test_flaky_t __attribute__((used)) __attribute__((section("_test_flaky"))) \
+    _name##_flaky = { .name = #_name, .retries = _retries }
 
 void arch_init_simple(env_t env, simple_t *simple);
 
@@ -62,6 +62,7 @@ int setup_faulter_thread_for_test(struct env *env, helper_thread_t *faulter_thre
     /* Make the kernel send all faults to the endpoint that the handler thread
      * will be told to listen on.
      */
+    page_in_image(env);
     error = api_tcb_set_space(
                 get_helper_tcb(faulter_thread),
                 badged_fault_ep_cspath.capPtr,
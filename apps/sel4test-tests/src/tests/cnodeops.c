@@ -55,7 +55,7 @@ static int test_cnode_copy(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0001, "Basic seL4_CNode_Copy() testing", test_cnode_copy, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0001, "Basic seL4_CNode_Copy() testing", test_cnode_copy, true)
 
 static int
 test_cnode_delete(env_t env)
@@ -77,7 +77,7 @@ test_cnode_delete(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0002, "Basic seL4_CNode_Delete() testing", test_cnode_delete, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0002, "Basic seL4_CNode_Delete() testing", test_cnode_delete, true)
 
 static int
 test_cnode_mint(env_t env)
@@ -106,7 +106,7 @@ test_cnode_mint(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0003, "Basic seL4_CNode_Mint() testing", test_cnode_mint, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0003, "Basic seL4_CNode_Mint() testing", test_cnode_mint, true)
 
 static int
 test_cnode_move(env_t env)
@@ -139,7 +139,7 @@ test_cnode_move(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0004, "Basic seL4_CNode_Move() testing", test_cnode_move, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0004, "Basic seL4_CNode_Move() testing", test_cnode_move, true)
 
 static int
 test_cnode_mutate(env_t env)
@@ -173,7 +173,7 @@ test_cnode_mutate(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0005, "Basic seL4_CNode_Mutate() testing", test_cnode_mutate, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0005, "Basic seL4_CNode_Mutate() testing", test_cnode_mutate, true)
 
 static int
 test_cnode_cancelBadgedSends(env_t env)
@@ -195,7 +195,8 @@ test_cnode_cancelBadgedSends(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0006, "Basic seL4_CNode_CancelBadgedSends() testing", test_cnode_cancelBadgedSends, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0006, "Basic seL4_CNode_CancelBadgedSends() testing",
+                       test_cnode_cancelBadgedSends, true)
 
 static int
 test_cnode_revoke(env_t env)
@@ -217,7 +218,7 @@ test_cnode_revoke(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0007, "Basic seL4_CNode_Revoke() testing", test_cnode_revoke, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0007, "Basic seL4_CNode_Revoke() testing", test_cnode_revoke, true)
 
 static int
 test_cnode_rotate(env_t env)
@@ -275,7 +276,7 @@ test_cnode_rotate(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0008, "Basic seL4_CNode_Rotate() testing", test_cnode_rotate, true)
+DEFINE_TEST_PERSISTENT(CNODEOP0008, "Basic seL4_CNode_Rotate() testing", test_cnode_rotate, true)
 
 
 static int
@@ -299,4 +300,5 @@ test_cnode_savecaller(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(CNODEOP0009, "Basic seL4_CNode_SaveCaller() testing", test_cnode_savecaller, !config_set(CONFIG_KERNEL_MCS))
+DEFINE_TEST_PERSISTENT(CNODEOP0009, "Basic seL4_CNode_SaveCaller() testing", test_cnode_savecaller,
+                       !config_set(CONFIG_KERNEL_MCS))
@@ -744,6 +744,7 @@ static int test_fault(env_t env, int fault_type, bool inter_as)
         }
 
         set_helper_priority(env, &handler_thread, 101);
+        page_in_image(env);
         error = api_tcb_set_space(get_helper_tcb(&faulter_thread),
                                   fault_ep,
                                   faulter_cspace,
@@ -1078,6 +1079,7 @@ static int test_vm_enter_non_vm(env_t env)
     create_helper_thread(env, &helper);
 
     seL4_Word guard = seL4_WordBits - env->cspace_size_bits;
+    page_in_image(env);
     err = api_tcb_set_space(get_helper_tcb(&helper), fault_ep, env->cspace_root,
                             api_make_guard_skip_word(guard),
                             env->page_directory, seL4_NilData);
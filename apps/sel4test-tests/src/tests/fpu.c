@@ -248,6 +248,7 @@ int test_disable_enable(env_t env)
 
     create_helper_thread(env, &t);
 
+    page_in_image(env);
     /* Configure EP as fault EP */
     error = seL4_TCB_SetSpace(t.thread.tcb.cptr, t.local_endpoint.cptr,
                               env->cspace_root, 0,
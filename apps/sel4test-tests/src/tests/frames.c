@@ -154,6 +154,7 @@ static int test_xn(env_t env, seL4_ArchObjectType frame_type)
     helper_thread_t faulter;
     create_helper_thread(env, &faulter);
     set_helper_priority(env, &faulter, 100);
+    page_in_image(env);
     err = api_tcb_set_space(get_helper_tcb(&faulter),
                             fault_ep,
                             env->cspace_root,
@@ -194,6 +195,7 @@ static int test_xn(env_t env, seL4_ArchObjectType frame_type)
     /* Recreate our two threads. */
     create_helper_thread(env, &faulter);
     set_helper_priority(env, &faulter, 100);
+    page_in_image(env);
     err = api_tcb_configure(get_helper_tcb(&faulter),
                             fault_ep, seL4_CapNull,
                             get_helper_sched_context(&faulter),
@@ -346,6 +348,7 @@ static int test_unmap_on_delete(env_t env)
     helper_thread_t faulter;
     create_helper_thread(env, &faulter);
     set_helper_priority(env, &faulter, 100);
+    page_in_image(env);
     err = api_tcb_set_space(get_helper_tcb(&faulter),
                             fault_ep,
                             env->cspace_root,
@@ -108,7 +108,7 @@ static int test_retype(env_t env)
     vka_free_object(&env->vka, &cnode);
     return sel4test_get_result();
 }
-DEFINE_TEST(RETYPE0000, "Retype test", test_retype, true)
+DEFINE_TEST_PERSISTENT(RETYPE0000, "Retype test", test_retype, true)
 
 static int
 test_incretype(env_t env)
@@ -149,7 +149,7 @@ test_incretype(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(RETYPE0001, "Incremental retype test", test_incretype, true)
+DEFINE_TEST_PERSISTENT(RETYPE0001, "Incremental retype test", test_incretype, true)
 
 static int
 test_incretype2(env_t env)
@@ -204,4 +204,52 @@ test_incretype2(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(RETYPE0002, "Incremental retype test #2", test_incretype2, true)
+DEFINE_TEST_PERSISTENT(RETYPE0002, "Incremental retype test #2", test_incretype2, true)
+
+/* Most untypeds test_most_memory holds at once */
+#define MOST_MEMORY_UNTYPEDS 4096
+
+/* Below this much RAM, what the driver keeps for itself is more than 10% */
+#define MOST_MEMORY_MIN_RAM (2ull << 30)
+
+static int test_most_memory(env_t env)
+{
+    static vka_object_t untypeds[MOST_MEMORY_UNTYPEDS];
+    test_init_data_t *init = (test_init_data_t *) env->simple.data;
+    seL4_Word allocated = 0;
+    int n = 0;
+
+    if (init->total_ram_bytes < MOST_MEMORY_MIN_RAM) {
+        printf("Only %llu MiB of RAM, skipping test\n", (unsigned long long)(init->total_ram_bytes >> 20));
+        return sel4test_get_result();
+    }
+
+    int bits = seL4_WordBits - 1;
+    while (bits > seL4_PageBits && BIT(bits) > init->total_ram_bytes) {
+        bits--;
+    }
+
+    /* take as much memory as the driver hands out, largest first */
+    for (; bits >= seL4_PageBits && n < MOST_MEMORY_UNTYPEDS; bits--) {
+        while (n < MOST_MEMORY_UNTYPEDS && vka_alloc_untyped(&env->vka, bits, &untypeds[n]) == 0) {
+            allocated += BIT(bits);
+            n++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        vka_free_object(&env->vka, &untypeds[i]);
+    }
+
+    ZF_LOGI("Allocated %llu of %llu bytes of RAM", (unsigned long long) allocated,
+            (unsigned long long) init->total_ram_bytes);
+    /* as a fraction, so that it does not overflow */
+    test_gt(allocated / 9, init->total_ram_bytes / 10);
+
+    return sel4test_get_result();
+}
+/* Meant for a simulated machine with a few GiB of RAM. Only one test process
+ * has the memory of the tests at a time, and the largest untypeds only exist
+ * on 64 bit */
+DEFINE_TEST(RETYPE0003, "Tests can use more than 90% of RAM", test_most_memory,
+            config_set(CONFIG_SIMULATION) && CONFIG_WORD_SIZE == 64 && !config_set(CONFIG_PARALLEL_TESTS) &&
+            !config_set(CONFIG_BACKGROUND_TEARDOWN))
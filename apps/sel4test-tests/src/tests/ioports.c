@@ -98,6 +98,7 @@ static int test_native_ioports(env_t env)
     handler_arg1 = get_helper_tcb(&faulter_thread);
     set_helper_priority(env, &handler_thread, 100);
 
+    page_in_image(env);
     error = api_tcb_set_space(get_helper_tcb(&faulter_thread),
                               fault_ep,
                               faulter_cspace,
@@ -977,6 +977,7 @@ static int test_fault_handler_donated_sc(env_t env)
     int error = api_sc_unbind(handler.thread.sched_context.cptr);
     test_eq(error, seL4_NoError);
 
+    page_in_image(env);
     /* set fault handler */
     seL4_Word data = api_make_guard_skip_word(seL4_WordBits - env->cspace_size_bits);
     error = api_tcb_set_space(faulter.thread.tcb.cptr, endpoint,
@@ -235,6 +235,7 @@ static int smp_test_tlb_instance(env_t env, bool inter_as)
         vspace = &env->vspace;
     }
 
+    page_in_image(env);
     error = api_tcb_set_space(get_helper_tcb(&faulter_thread),
                               fault_ep_faulter,
                               faulter_cspace,
@@ -337,3 +338,7 @@ int smp_test_tcb_clh(env_t env)
 }
 DEFINE_TEST(MULTICORE0004, "Test core stalling is behaving properly (flaky)", smp_test_tcb_clh,
             CONFIG_MAX_NUM_NODES > 1)
+/* it is known to hang or fail now and then, and normally finishes in well
+ * under a second */
+DEFINE_TEST_DEADLINE(MULTICORE0004, 10000);
+DEFINE_TEST_FLAKY(MULTICORE0004, 3);
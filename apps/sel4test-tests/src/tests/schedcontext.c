@@ -759,6 +759,7 @@ int test_smp_delete_sched_context(env_t env)
     /* Run it on another core and time it such that it runs out of budget during the SC free */
     *p = sched_params_periodic(*p, &env->simple, core, 10 * US_IN_MS, MIN_BUDGET_US, 0, 0);
 
+    page_in_image(env);
     error = sel4utils_configure_thread_config(&env->vka, &env->vspace, &env->vspace, config, &thread);
     assert(error == 0);
 
@@ -103,6 +103,10 @@ static int test_thread_suspend(env_t env)
 }
 DEFINE_TEST(SCHED0000, "Test suspending and resuming a thread (flaky)", test_thread_suspend,
             config_set(CONFIG_HAVE_TIMER))
+/* it is known to hang or fail now and then, and normally finishes in well
+ * under a second */
+DEFINE_TEST_DEADLINE(SCHED0000, 10000);
+DEFINE_TEST_FLAKY(SCHED0000, 3);
 
 /*
  * Test TCB Resume on self.
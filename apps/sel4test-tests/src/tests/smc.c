@@ -68,7 +68,7 @@ static int test_smc_calls(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(SMC0001, "Test SMC calls", test_smc_calls, true)
+DEFINE_TEST_PERSISTENT(SMC0001, "Test SMC calls", test_smc_calls, true)
 
 
 int test_smc_2(env_t env)
@@ -81,7 +81,7 @@ int test_smc_2(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(SMC0002, "SMC Caps can be copied", test_smc_2, true)
+DEFINE_TEST_PERSISTENT(SMC0002, "SMC Caps can be copied", test_smc_2, true)
 
 int test_smc_3(env_t env)
 {
@@ -97,7 +97,7 @@ int test_smc_3(env_t env)
     return sel4test_get_result();
 }
 
-DEFINE_TEST(SMC0003, "Copied SMC Caps lose revocable authority", test_smc_3, true)
+DEFINE_TEST_PERSISTENT(SMC0003, "Copied SMC Caps lose revocable authority", test_smc_3, true)
 
 int test_smc_4(env_t env)
 {
@@ -110,7 +110,7 @@ int test_smc_4(env_t env)
     return sel4test_get_result();
 }
 
-DEFINE_TEST(SMC0004, "Unbadged SMC Caps can be badged", test_smc_4, true)
+DEFINE_TEST_PERSISTENT(SMC0004, "Unbadged SMC Caps can be badged", test_smc_4, true)
 
 
 int test_smc_5(env_t env)
@@ -129,7 +129,7 @@ int test_smc_5(env_t env)
     return sel4test_get_result();
 }
 
-DEFINE_TEST(SMC0005, "Badged SMC caps cannot change badge", test_smc_5, true)
+DEFINE_TEST_PERSISTENT(SMC0005, "Badged SMC caps cannot change badge", test_smc_5, true)
 
 int test_smc_6(env_t env)
 {
@@ -146,7 +146,7 @@ int test_smc_6(env_t env)
 
     return sel4test_get_result();
 }
-DEFINE_TEST(SMC0006, "Badged SMC caps can be copied", test_smc_6, true)
+DEFINE_TEST_PERSISTENT(SMC0006, "Badged SMC caps can be copied", test_smc_6, true)
 
 
 int test_smc_7(env_t env)
@@ -168,7 +168,7 @@ int test_smc_7(env_t env)
     return sel4test_get_result();
 }
 
-DEFINE_TEST(SMC0007, "Original badged SMC caps can revoke copies", test_smc_7, true)
+DEFINE_TEST_PERSISTENT(SMC0007, "Original badged SMC caps can revoke copies", test_smc_7, true)
 
 int test_smc_8(env_t env)
 {
@@ -197,6 +197,6 @@ int test_smc_8(env_t env)
 }
 
 
-DEFINE_TEST(SMC0008, "Original badged SMC caps don't revoke other original badges", test_smc_8, true)
+DEFINE_TEST_PERSISTENT(SMC0008, "Original badged SMC caps don't revoke other original badges", test_smc_8, true)
 
 #endif
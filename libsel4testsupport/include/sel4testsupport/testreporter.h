@@ -20,3 +20,11 @@
  */
 testcase_t *sel4test_get_test(const char *name);
 
+/*
+ * Get a testcase by its index in the test case section.
+ *
+ * @param index the index of the test to retrieve.
+ * @return the test at index, NULL if index is out of range.
+ */
+testcase_t *sel4test_get_test_by_index(int index);
+
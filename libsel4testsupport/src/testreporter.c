@@ -41,3 +41,12 @@ testcase_t *sel4test_get_test(const char *name)
     return NULL;
 }
 
+testcase_t *sel4test_get_test_by_index(int index)
+{
+    if (index < 0 || index >= __stop__test_case - __start__test_case) {
+        return NULL;
+    }
+
+    return &__start__test_case[index];
+}
+